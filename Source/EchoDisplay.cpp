@@ -0,0 +1,108 @@
+#include "EchoDisplay.h"
+
+namespace
+{
+constexpr float kMeterWidth = 70.0f;
+constexpr float kMinimumDecibels = -60.0f;
+
+float levelToProportion(float level)
+{
+    const float decibels = juce::Decibels::gainToDecibels(level, kMinimumDecibels);
+    return juce::jlimit(0.0f, 1.0f, (decibels - kMinimumDecibels) / -kMinimumDecibels);
+}
+
+void drawMeter(juce::Graphics& g, juce::Rectangle<float> bar, float peak, float rms, juce::Colour colour)
+{
+    g.setColour(juce::Colour(0xff23252a));
+    g.fillRect(bar);
+
+    g.setColour(colour.withAlpha(0.45f));
+    g.fillRect(bar.withTop(bar.getBottom() - bar.getHeight() * levelToProportion(peak)));
+
+    g.setColour(colour);
+    g.fillRect(bar.withTop(bar.getBottom() - bar.getHeight() * levelToProportion(rms)));
+}
+}
+
+EchoDisplay::EchoDisplay()
+{
+    setOpaque(true);
+}
+
+void EchoDisplay::update(const echo::MeterSnapshot& snapshot)
+{
+    latest = snapshot;
+    rebuildOverviewPath();
+    repaint();
+}
+
+void EchoDisplay::resized()
+{
+    auto area = getLocalBounds().toFloat().reduced(4.0f);
+    meterArea = area.removeFromRight(kMeterWidth);
+    overviewArea = area.withTrimmedRight(6.0f);
+    rebuildOverviewPath();
+}
+
+void EchoDisplay::rebuildOverviewPath()
+{
+    constexpr int numColumns = echo::MeterSnapshot::kOverviewColumns;
+
+    overviewPath.clear();
+
+    if (overviewArea.isEmpty())
+        return;
+
+    const float columnWidth = overviewArea.getWidth() / static_cast<float>(numColumns);
+    const float centreY = overviewArea.getCentreY();
+    const float halfHeight = overviewArea.getHeight() * 0.5f;
+
+    // Upper edge from the maxima left to right, lower edge back from the minima.
+    for (int column = 0; column < numColumns; ++column)
+    {
+        const float x = overviewArea.getX() + (static_cast<float>(column) + 0.5f) * columnWidth;
+        const float y = centreY - juce::jlimit(-1.0f, 1.0f, latest.overviewMax[column]) * halfHeight;
+
+        if (column == 0)
+            overviewPath.startNewSubPath(x, y);
+        else
+            overviewPath.lineTo(x, y);
+    }
+
+    for (int column = numColumns; --column >= 0;)
+    {
+        const float x = overviewArea.getX() + (static_cast<float>(column) + 0.5f) * columnWidth;
+        overviewPath.lineTo(x, centreY - juce::jlimit(-1.0f, 1.0f, latest.overviewMin[column]) * halfHeight);
+    }
+
+    overviewPath.closeSubPath();
+}
+
+void EchoDisplay::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colour(0xff1d1f23));
+
+    g.setColour(juce::Colour(0xff5fb3d9));
+    g.fillPath(overviewPath);
+
+    // The current delay, measured back from the write head at the right edge.
+    const float spanFrames = static_cast<float>(echo::MeterSnapshot::kOverviewColumns * latest.framesPerColumn);
+    const float delayX = overviewArea.getRight() - overviewArea.getWidth() * juce::jlimit(0.0f, 1.0f, latest.delaySamples / spanFrames);
+    g.setColour(juce::Colours::whitesmoke.withAlpha(0.7f));
+    g.drawVerticalLine(juce::roundToInt(delayX), overviewArea.getY(), overviewArea.getBottom());
+
+    auto meters = meterArea;
+    const float barWidth = meters.getWidth() / 5.0f;
+    const auto inputColour = juce::Colour(0xff7fd17f);
+    const auto outputColour = juce::Colour(0xffe0c060);
+
+    drawMeter(g, meters.removeFromLeft(barWidth).reduced(1.0f, 0.0f), latest.inputPeak[0], latest.inputRms[0], inputColour);
+    drawMeter(g, meters.removeFromLeft(barWidth).reduced(1.0f, 0.0f), latest.inputPeak[1], latest.inputRms[1], inputColour);
+    drawMeter(g, meters.removeFromLeft(barWidth).reduced(1.0f, 0.0f), latest.outputPeak[0], latest.outputRms[0], outputColour);
+    drawMeter(g, meters.removeFromLeft(barWidth).reduced(1.0f, 0.0f), latest.outputPeak[1], latest.outputRms[1], outputColour);
+
+    // The loop level turns red once it exceeds full scale, which is where a
+    // high feedback setting with drive starts to run away.
+    const auto loopColour = latest.loopPeak > 1.0f ? juce::Colour(0xffe05050) : juce::Colour(0xffb08fe0);
+    drawMeter(g, meters.reduced(1.0f, 0.0f), latest.loopPeak, latest.loopPeak, loopColour);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Engine/Metering.h"
+
+/** Scrolling overview of the delay line plus input, output and loop meters.
+
+    update() copies the snapshot and rebuilds the overview path; paint() only
+    draws what is cached, so repaints triggered by anything else stay cheap.
+*/
+class EchoDisplay final : public juce::Component
+{
+public:
+    EchoDisplay();
+
+    void update(const echo::MeterSnapshot& snapshot);
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void rebuildOverviewPath();
+
+    echo::MeterSnapshot latest;
+    juce::Path overviewPath;
+    juce::Rectangle<float> overviewArea;
+    juce::Rectangle<float> meterArea;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EchoDisplay)
+};
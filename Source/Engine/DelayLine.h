@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "HalfFloat.h"
+
+namespace echo
+{
+/** Sample format of the delay line. */
+enum class DelayStorage
+{
+    full,       // the engine's own sample type, float or double
+    half        // IEEE half floats: 16 bits per sample, 11 significant bits
+};
+
+constexpr int kNumDelayStorages = 2;
+
+/** Ring buffer of interleaved multichannel frames of Sample (float or
+    double).
+
+    The capacity is rounded up to a power of two so positions wrap with a
+    mask instead of a modulo, and all channels of a frame share a cache line.
+    Positions are frame indices; any int (including negative offsets from
+    the write head) is wrapped with the mask.
+
+    Frames are stored as Sample or as half floats. Either way they are read
+    and written as Sample: reads hand out Sample frames (pointing straight
+    into a full-precision line where possible) and writes convert on the
+    way in.
+
+    clear() doesn't touch the memory. The line counts the frames the write
+    head has passed since, and reads of anything older come back as
+    silence; the stale frames are overwritten as the head comes round.
+*/
+template <typename Sample>
+class DelayLine
+{
+public:
+    /** Allocates and clears the line. Not real-time safe. */
+    void prepare(int minimumFrames, int channels, DelayStorage format)
+    {
+        int frames = 1;
+        while (frames < minimumFrames)
+            frames <<= 1;
+
+        storage = format;
+        numChannels = channels;
+        capacity = frames;
+        mask = frames - 1;
+
+        const size_t numValues = static_cast<size_t>(capacity) * static_cast<size_t>(numChannels);
+        fullFrames.assign(storage == DelayStorage::full ? numValues : 0, Sample(0));
+        halfFrames.assign(storage == DelayStorage::half ? numValues : 0, 0);
+        fullFrames.shrink_to_fit();
+        halfFrames.shrink_to_fit();
+        writePosition = 0;
+        validFrames = 0;
+    }
+
+    void release()
+    {
+        fullFrames = {};
+        halfFrames = {};
+        capacity = 0;
+        mask = 0;
+        writePosition = 0;
+        validFrames = 0;
+    }
+
+    /** Makes the whole line read as silence, in constant time. */
+    void clear() noexcept
+    {
+        writePosition = 0;
+        validFrames = 0;
+    }
+
+    /** Exchanges everything with another line without allocating. */
+    void swap(DelayLine& other) noexcept
+    {
+        fullFrames.swap(other.fullFrames);
+        halfFrames.swap(other.halfFrames);
+        std::swap(storage, other.storage);
+        std::swap(numChannels, other.numChannels);
+        std::swap(capacity, other.capacity);
+        std::swap(mask, other.mask);
+        std::swap(writePosition, other.writePosition);
+        std::swap(validFrames, other.validFrames);
+    }
+
+    /** Starts taking over the valid frames of another line (the newest
+        ones, as many as fit), converting the format if needed. The copy is
+        done by continueCopy(), a slice at a time, while the source line
+        stays in use.
+    */
+    void beginCopy(const DelayLine& source) noexcept
+    {
+        copyEnd = source.writePosition;
+        copyPosition = copyEnd - std::min(capacity, source.validFrames);
+        copyStart = copyPosition;
+    }
+
+    /** Copies up to maxFrames more frames, oldest first, including any the
+        source has had written since the last call. Returns true once it has
+        caught up with the source's write head; the line then has the
+        source's frames and write position, and anything older reads as
+        silence.
+
+        Call it before each block that writes the source, with maxFrames
+        above that block's length, so the copy gains on the write head and
+        stays ahead of the frames the block overwrites. The newest
+        heldFrames may still be written again, so only the call that
+        finishes copies them; heldFrames must be well below maxFrames.
+    */
+    bool continueCopy(const DelayLine& source, int maxFrames, int heldFrames) noexcept
+    {
+        // Positions here don't wrap; the head has moved less than a
+        // capacity since the last call.
+        copyEnd += (source.writePosition - copyEnd) & source.mask;
+
+        const int numFrames = copyEnd - copyPosition <= maxFrames
+                                ? copyEnd - copyPosition
+                                : std::clamp(copyEnd - heldFrames - copyPosition, 0, maxFrames);
+        copyFrames(source, copyPosition, numFrames);
+        copyPosition += numFrames;
+
+        if (copyPosition != copyEnd)
+            return false;
+
+        writePosition = copyEnd & mask;
+        validFrames = std::min(capacity, copyEnd - copyStart);
+        return true;
+    }
+
+    bool isEmpty() const noexcept { return capacity == 0; }
+    int getCapacity() const noexcept { return capacity; }
+    int getNumChannels() const noexcept { return numChannels; }
+    int getMask() const noexcept { return mask; }
+    DelayStorage getStorage() const noexcept { return storage; }
+
+    int getWritePosition() const noexcept { return writePosition; }
+    void advance(int numFrames) noexcept
+    {
+        writePosition = (writePosition + numFrames) & mask;
+        validFrames = std::min(validFrames + numFrames, capacity);
+    }
+
+    /** Frames [position, position + numFrames) as one contiguous run: a
+        pointer into the line if it is full precision and the run doesn't wrap,
+        otherwise the frames are gathered into scratch, which must hold
+        numFrames frames.
+    */
+    const Sample* getFrames(int position, int numFrames, Sample* scratch) const noexcept
+    {
+        const int start = position & mask;
+        const int firstFrames = std::min(numFrames, capacity - start);
+
+        if (storage == DelayStorage::full && firstFrames == numFrames && getStaleFrames(position, numFrames) == 0)
+            return fullFrames.data() + static_cast<size_t>(start) * static_cast<size_t>(numChannels);
+
+        read(position, numFrames, scratch);
+        return scratch;
+    }
+
+    /** Copies frames [position, position + numFrames) out. */
+    void read(int position, int numFrames, Sample* destination) const noexcept
+    {
+        // Stale frames are the oldest ones, at the start of the run.
+        const int staleFrames = getStaleFrames(position, numFrames);
+        std::fill(destination, destination + staleFrames * numChannels, Sample(0));
+        position += staleFrames;
+        numFrames -= staleFrames;
+        destination += staleFrames * numChannels;
+
+        const int start = position & mask;
+        const int firstFrames = std::min(numFrames, capacity - start);
+
+        readRun(start, firstFrames, destination);
+        readRun(0, numFrames - firstFrames, destination + firstFrames * numChannels);
+    }
+
+    /** One frame; scratch must hold one frame. */
+    const Sample* getFrame(int position, Sample* scratch) const noexcept
+    {
+        const size_t start = static_cast<size_t>(position & mask) * static_cast<size_t>(numChannels);
+
+        if (getStaleFrames(position, 1) != 0)
+        {
+            std::fill(scratch, scratch + numChannels, Sample(0));
+            return scratch;
+        }
+
+        if (storage == DelayStorage::full)
+            return fullFrames.data() + start;
+
+        half::decode(halfFrames.data() + start, scratch, numChannels);
+        return scratch;
+    }
+
+    /** One channel of one frame, for reads whose position differs per channel. */
+    Sample getSample(int position, int channel) const noexcept
+    {
+        if (getStaleFrames(position, 1) != 0)
+            return Sample(0);
+
+        const size_t index = static_cast<size_t>(position & mask) * static_cast<size_t>(numChannels)
+                           + static_cast<size_t>(channel);
+
+        if (storage == DelayStorage::full)
+            return fullFrames[index];
+
+        return static_cast<Sample>(half::toFloat(halfFrames[index]));
+    }
+
+    /** Stores numFrames interleaved frames starting at position. */
+    void write(int position, const Sample* frames, int numFrames) noexcept
+    {
+        const int start = position & mask;
+        const int firstFrames = std::min(numFrames, capacity - start);
+
+        writeRun(start, frames, firstFrames);
+        writeRun(0, frames + firstFrames * numChannels, numFrames - firstFrames);
+    }
+
+private:
+    /** Copies source frames [position, position + numFrames) to the same
+        positions here.
+    */
+    void copyFrames(const DelayLine& source, int position, int numFrames) noexcept
+    {
+        for (int remaining = numFrames; remaining > 0;)
+        {
+            const int sourceStart = position & source.mask;
+            const int count = std::min({ remaining, source.capacity - sourceStart, capacity - (position & mask) });
+
+            if (source.storage == DelayStorage::full)
+                write(position, source.fullFrames.data() + static_cast<size_t>(sourceStart) * static_cast<size_t>(numChannels), count);
+            else if (storage == DelayStorage::half)
+                std::memcpy(halfFrames.data() + static_cast<size_t>(position & mask) * static_cast<size_t>(numChannels),
+                            source.halfFrames.data() + static_cast<size_t>(sourceStart) * static_cast<size_t>(numChannels),
+                            sizeof(uint16_t) * static_cast<size_t>(count * numChannels));
+            else
+                half::decode(source.halfFrames.data() + static_cast<size_t>(sourceStart) * static_cast<size_t>(numChannels),
+                             fullFrames.data() + static_cast<size_t>(position & mask) * static_cast<size_t>(numChannels),
+                             count * numChannels);
+
+            position += count;
+            remaining -= count;
+        }
+    }
+
+    /** How many frames at the start of [position, position + numFrames)
+        are older than the last clear(). Positions are taken relative to
+        the write head, so they must be at most one capacity behind it.
+    */
+    int getStaleFrames(int position, int numFrames) const noexcept
+    {
+        const int age = writePosition - position;
+        return std::clamp(age - validFrames, 0, numFrames);
+    }
+
+    void readRun(int start, int numFrames, Sample* destination) const noexcept
+    {
+        const size_t offset = static_cast<size_t>(start) * static_cast<size_t>(numChannels);
+        const int numValues = numFrames * numChannels;
+
+        if (storage == DelayStorage::full)
+            std::memcpy(destination, fullFrames.data() + offset, sizeof(Sample) * static_cast<size_t>(numValues));
+        else
+            half::decode(halfFrames.data() + offset, destination, numValues);
+    }
+
+    void writeRun(int start, const Sample* source, int numFrames) noexcept
+    {
+        const size_t offset = static_cast<size_t>(start) * static_cast<size_t>(numChannels);
+        const int numValues = numFrames * numChannels;
+
+        if (storage == DelayStorage::full)
+            std::memcpy(fullFrames.data() + offset, source, sizeof(Sample) * static_cast<size_t>(numValues));
+        else
+            half::encode(source, halfFrames.data() + offset, numValues);
+    }
+
+    std::vector<Sample> fullFrames;
+    std::vector<uint16_t> halfFrames;
+    DelayStorage storage = DelayStorage::full;
+    int numChannels = 0;
+    int capacity = 0;
+    int mask = 0;
+    int writePosition = 0;
+    int validFrames = 0;
+
+    // Progress of a copy from another line, in that line's positions
+    // without wrapping.
+    int copyStart = 0;
+    int copyPosition = 0;
+    int copyEnd = 0;
+};
+}
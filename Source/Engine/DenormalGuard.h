@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define ECHO_DENORMAL_GUARD_SSE 1
+#endif
+
+namespace echo
+{
+/** Enables flush-to-zero/denormals-are-zero for the lifetime of the object,
+    like juce::ScopedNoDenormals but without depending on JUCE.
+*/
+class DenormalGuard
+{
+public:
+    DenormalGuard() noexcept
+    {
+       #if ECHO_DENORMAL_GUARD_SSE
+        previous = _mm_getcsr();
+        _mm_setcsr(previous | 0x8040u);
+       #elif defined(__aarch64__)
+        std::uint64_t fpcr;
+        asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+        previous = fpcr;
+        fpcr |= (1ull << 24);
+        asm volatile("msr fpcr, %0" : : "r"(fpcr));
+       #endif
+    }
+
+    ~DenormalGuard() noexcept
+    {
+       #if ECHO_DENORMAL_GUARD_SSE
+        _mm_setcsr(static_cast<unsigned int>(previous));
+       #elif defined(__aarch64__)
+        asm volatile("msr fpcr, %0" : : "r"(previous));
+       #endif
+    }
+
+    DenormalGuard(const DenormalGuard&) = delete;
+    DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+private:
+    std::uint64_t previous = 0;
+};
+}
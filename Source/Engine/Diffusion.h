@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace echo
+{
+/** Settings for the allpass diffusion stage in the feedback loop, which
+    smears each repeat a little more on every trip round it.
+*/
+struct DiffusionParameters
+{
+    float amount = 0.0f;    // 0..1, the allpass coefficient up to kMaxCoefficient; 0 takes the stage out of the loop
+    float size = 0.5f;      // 0..1, scales the allpass delays from kMinSize of their full length to all of it
+};
+
+namespace diffusion
+{
+/** Schroeder allpasses in series. */
+constexpr int kNumStages = 4;
+
+/** Ring 0 is a plain delay that tops the allpass delays up to the
+    network's full-size length; rings 1.. are the allpasses.
+*/
+constexpr int kNumRings = kNumStages + 1;
+constexpr int kNumLanes = 4;
+
+constexpr float kMaxCoefficient = 0.7f;
+constexpr float kMinSize = 0.25f;
+
+/** Allpass delays at full size. No two are near a ratio of small whole
+    numbers, so their echoes don't pile up on the same frames.
+*/
+constexpr double kStageMs[kNumStages] = { 1.53, 2.47, 3.61, 5.19 };
+
+/** Delay of one allpass, in frames, for a size in 0..1. */
+inline int getStageFrames(int stage, double sampleRate, float size) noexcept
+{
+    const double scale = kMinSize + (1.0 - kMinSize) * std::clamp(static_cast<double>(size), 0.0, 1.0);
+    return std::max(1, static_cast<int>(std::lround(kStageMs[stage] * scale * sampleRate / 1000.0)));
+}
+
+/** The network's delay in frames: all allpasses at full size. Ring 0 makes
+    up the difference at smaller sizes, so it is the same at every size.
+*/
+inline int getLatencySamples(double sampleRate) noexcept
+{
+    int frames = 0;
+
+    for (int stage = 0; stage < kNumStages; ++stage)
+        frames += getStageFrames(stage, sampleRate, 1.0f);
+
+    return frames;
+}
+
+/** Frames in a ring: a power of two above the longest delay it takes. */
+inline int getRingFrames(int ring, double sampleRate) noexcept
+{
+    int longest = 0;
+
+    if (ring == 0)
+    {
+        longest = getLatencySamples(sampleRate);
+
+        for (int stage = 0; stage < kNumStages; ++stage)
+            longest -= getStageFrames(stage, sampleRate, 0.0f);
+    }
+    else
+    {
+        longest = getStageFrames(ring - 1, sampleRate, 1.0f);
+    }
+
+    int frames = 1;
+    while (frames <= longest)
+        frames <<= 1;
+
+    return frames;
+}
+
+/** Frames one channel group takes in the arena: all of its rings. */
+inline int getRegionFrames(double sampleRate) noexcept
+{
+    int frames = 0;
+
+    for (int ring = 0; ring < kNumRings; ++ring)
+        frames += getRingFrames(ring, sampleRate);
+
+    return frames;
+}
+}
+
+/** One frame of a diffusion ring: a sample per lane, aligned for
+    whole-register loads.
+*/
+template <typename Sample>
+struct alignas(diffusion::kNumLanes * sizeof(Sample)) DiffuserFrame
+{
+    Sample lanes[diffusion::kNumLanes];
+};
+
+/** The diffusion network of one channel group.
+
+    Its rings sit back to back in the group's region of the engine's arena,
+    each a power of two long so reads and writes wrap with a mask. A frame
+    holds every lane, so the kernel runs all channels of the group through
+    the network with one load and one store per ring and frame, and the
+    rows it touches move through a few kilobytes of memory together.
+*/
+template <typename Sample>
+struct DiffuserLanes
+{
+    static constexpr int kNumLanes = diffusion::kNumLanes;
+
+    DiffuserFrame<Sample>* frames = nullptr;
+    int regionFrames = 0;
+    int offsets[diffusion::kNumRings] = {};
+    int masks[diffusion::kNumRings] = {};
+    int delays[diffusion::kNumRings] = {};
+
+    /** The write position, wrapped to the longest ring; the shorter rings'
+        masks take it from there.
+    */
+    int position = 0;
+    int positionMask = 0;
+    int latency = 0;
+
+    /** Lays the rings out in a region of getRegionFrames() frames, or
+        detaches the group if region is null.
+    */
+    void prepare(DiffuserFrame<Sample>* region, double sampleRate) noexcept
+    {
+        frames = region;
+        regionFrames = region != nullptr ? diffusion::getRegionFrames(sampleRate) : 0;
+        latency = diffusion::getLatencySamples(sampleRate);
+        positionMask = 0;
+
+        for (int ring = 0, offset = 0; ring < diffusion::kNumRings; ++ring)
+        {
+            const int ringFrames = diffusion::getRingFrames(ring, sampleRate);
+            offsets[ring] = offset;
+            masks[ring] = ringFrames - 1;
+            positionMask = std::max(positionMask, masks[ring]);
+            offset += ringFrames;
+        }
+
+        setSize(sampleRate, 1.0f);
+        clear();
+    }
+
+    void setSize(double sampleRate, float size) noexcept
+    {
+        delays[0] = latency;
+
+        for (int stage = 0; stage < diffusion::kNumStages; ++stage)
+        {
+            delays[stage + 1] = diffusion::getStageFrames(stage, sampleRate, size);
+            delays[0] -= delays[stage + 1];
+        }
+    }
+
+    void clear() noexcept
+    {
+        if (frames != nullptr)
+            std::fill(frames, frames + regionFrames, DiffuserFrame<Sample> {});
+
+        position = 0;
+    }
+};
+}
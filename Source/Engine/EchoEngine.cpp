@@ -0,0 +1,1409 @@
+#include "EchoEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+#include "DenormalGuard.h"
+
+namespace echo
+{
+namespace
+{
+constexpr double kSmoothingSeconds = 0.05;
+
+// Frames the delay line needs beyond the longest delay: the 4-point
+// interpolators read two frames past it.
+constexpr int kDelayLineMargin = 4;
+constexpr float kHalfPi = 1.57079632679489661923f;
+constexpr double kModulationSegmentsPerCycle = 64.0;
+
+// Room in writeScratch beyond a chunk and the held frames, so the held
+// frames move back to its start only once every few thousand frames rather
+// than after every chunk.
+constexpr int kWriteScratchSlackFrames = 4096;
+
+// Frames of the old delay line copied into a grown one per block, on top of
+// the block's own, so no one block pays for copying the whole line.
+constexpr int kLineCopyFrames = 16384;
+
+float decibelsToGain(float decibels) noexcept
+{
+    return decibels > -100.0f ? std::pow(10.0f, decibels * 0.05f) : 0.0f;
+}
+
+template <typename Sample>
+Sample getPeak(const Sample* data, int numValues) noexcept
+{
+    Sample peak = 0;
+
+    for (int i = 0; i < numValues; ++i)
+        peak = std::max(peak, std::abs(data[i]));
+
+    return peak;
+}
+
+/** Advances a smoother by numFrames and returns the ramp it followed. */
+ControlRamp advanceRamp(LinearSmoother& smoother, int numFrames) noexcept
+{
+    if (! smoother.isSmoothing())
+        return { smoother.getTargetValue(), 0.0f };
+
+    const float start = smoother.getCurrentValue();
+    const float step = (smoother.skip(numFrames) - start) / static_cast<float>(numFrames);
+    return { start + step, step };
+}
+
+/** The ramp through two values at the first and last frame of a chunk. */
+ControlRamp makeRamp(float first, float last, int numFrames) noexcept
+{
+    return { first, numFrames > 1 ? (last - first) / static_cast<float>(numFrames - 1) : 0.0f };
+}
+
+/** Left and right gains for a tap; pan is a balance control, so the
+    centre position passes both sides at full gain.
+*/
+void getTapGains(float gain, float pan, float& left, float& right) noexcept
+{
+    left = gain * std::min(1.0f, 1.0f - pan);
+    right = gain * std::min(1.0f, 1.0f + pan);
+}
+
+/** Multiplies a run of samples by a ramp and adds them to destination. */
+template <typename Sample>
+void addRamped(Sample* destination, const Sample* source, ControlRamp gain, int numFrames) noexcept
+{
+    for (int i = 0; i < numFrames; ++i)
+        destination[i] += source[i] * gain.at(i);
+}
+
+DriveStage getDriveStage(float driveDb, DriveQuality quality) noexcept
+{
+    if (driveDb <= 0.0f)
+        return DriveStage::bypassed;
+
+    switch (quality)
+    {
+        case DriveQuality::exact: return DriveStage::exact;
+        case DriveQuality::table: return DriveStage::table;
+        case DriveQuality::rational:
+        default: return DriveStage::rational;
+    }
+}
+
+/** Reads one channel along a delay ramp. source(offset) returns the frame
+    offset frames from the write head (negative is older).
+
+    Three passes, so only the gather is scalar: read positions and weights
+    for the whole run, then the points they need, then the interpolation.
+*/
+template <Interpolation mode, typename Source, typename Sample>
+void readRamp(Source source, ControlRamp delay, int numFrames, Sample* destination, Sample& state) noexcept
+{
+    constexpr int maxFrames = BasicEchoEngine<Sample>::kMaxChunkFrames;
+    constexpr bool twoPoint = mode == Interpolation::linear || mode == Interpolation::allpass;
+    constexpr int numPoints = twoPoint ? 2 : 4;
+
+    // Each frame's newest point and its fraction (the coefficient for allpass).
+    int newest[maxFrames];
+    Sample fractions[maxFrames];
+    Sample points[numPoints][maxFrames];
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const float delaySamples = delay.at(i);
+
+        if constexpr (mode == Interpolation::allpass)
+        {
+            int tap = 0;
+            float coefficient = 0.0f;
+            interpolation::getAllpassTap(delaySamples, tap, coefficient);
+            newest[i] = i - tap;
+            fractions[i] = static_cast<Sample>(coefficient);
+        }
+        else
+        {
+            const int delaySamplesInt = static_cast<int>(delaySamples);
+            newest[i] = i - delaySamplesInt + interpolation::getLookahead(mode);
+            fractions[i] = static_cast<Sample>(delaySamples - static_cast<float>(delaySamplesInt));
+        }
+    }
+
+    for (int i = 0; i < numFrames; ++i)
+        for (int point = 0; point < numPoints; ++point)
+            points[point][i] = source(newest[i] - point);
+
+    if constexpr (mode == Interpolation::allpass)
+    {
+        for (int i = 0; i < numFrames; ++i)
+        {
+            state = fractions[i] * (points[0][i] - state) + points[1][i];
+            destination[i] = state;
+        }
+    }
+    else if constexpr (mode == Interpolation::linear)
+    {
+        for (int i = 0; i < numFrames; ++i)
+            destination[i] = points[0][i] + fractions[i] * (points[1][i] - points[0][i]);
+    }
+    else
+    {
+        for (int i = 0; i < numFrames; ++i)
+        {
+            Sample weights[4];
+            interpolation::getWeights<mode>(fractions[i], weights);
+            destination[i] = weights[0] * points[0][i] + weights[1] * points[1][i]
+                           + weights[2] * points[2][i] + weights[3] * points[3][i];
+        }
+    }
+}
+
+}
+
+template <typename Sample>
+float BasicEchoEngine<Sample>::getDivisionMultiplier(int choiceIndex) noexcept
+{
+    switch (choiceIndex)
+    {
+        case 0: return 1.0f;     // 1/1
+        case 1: return 0.5f;     // 1/2
+        case 2: return 0.25f;    // 1/4
+        case 3: return 0.125f;   // 1/8
+        case 4: return 0.0625f;  // 1/16
+        case 5: return 0.1666667f; // 1/8T
+        case 6: return 0.0833333f; // 1/16T
+        case 7: return 0.75f;    // 1/8D
+        case 8: return 0.375f;   // 1/16D
+        default: return 0.25f;
+    }
+}
+
+template <typename Sample>
+float BasicEchoEngine<Sample>::getSyncTimeSeconds(int choiceIndex, double bpm) noexcept
+{
+    const float multiplier = getDivisionMultiplier(choiceIndex);
+    const double quarterNoteSeconds = 60.0 / bpm;
+    return static_cast<float>(quarterNoteSeconds * 4.0 * multiplier);
+}
+
+template <typename Sample>
+double BasicEchoEngine<Sample>::getTailLengthSeconds(const EchoParameters& params) noexcept
+{
+    const bool synced = params.syncEnabled && params.hostBpm > 0.0;
+    const int numTaps = std::clamp(params.numTaps, 1, kMaxTaps);
+
+    // Bounded by the longest tap going round the loop with every tap's send
+    // adding up, which overestimates the tail of a spread-out pattern.
+    double delaySeconds = 0.0;
+    float totalSend = 0.0f;
+
+    for (int tap = 0; tap < numTaps; ++tap)
+    {
+        const float timeMs = tap == 0 ? params.timeMs : params.taps[tap].timeMs;
+        const int division = tap == 0 ? params.syncDivision : params.taps[tap].syncDivision;
+        const double tapSeconds = synced ? getSyncTimeSeconds(division, params.hostBpm)
+                                         : std::clamp(timeMs, 0.0f, static_cast<float>(kMaxDelayMs)) / 1000.0;
+
+        delaySeconds = std::max(delaySeconds, tapSeconds);
+        totalSend += std::clamp(params.taps[tap].feedbackSend, 0.0f, 1.0f);
+    }
+
+    // Modulation can stretch every trip by up to its depth.
+    delaySeconds += std::clamp(params.modulation.depthMs, 0.0f, modulation::kMaxDepthMs) / 1000.0;
+
+    // tanh has unit slope at zero, so quiet repeats see the full drive gain.
+    const float feedback = std::clamp(params.feedback, 0.0f, kFeedbackMax);
+    const float driveGain = getDriveStage(params.driveDb, params.driveQuality) == DriveStage::bypassed
+                          ? 1.0f : decibelsToGain(params.driveDb);
+    double loopGain = static_cast<double>(feedback) * driveGain * totalSend;
+
+    // A ping-pong matrix can add repeats together; its largest row sum
+    // bounds how much louder any channel gets per trip.
+    if (params.pingPong && params.pingPongRouting.useMatrix)
+    {
+        float largestRow = 0.0f;
+
+        for (const auto& row : params.pingPongRouting.matrix)
+        {
+            float rowSum = 0.0f;
+
+            for (float gain : row)
+                rowSum += std::abs(gain);
+
+            largestRow = std::max(largestRow, rowSum);
+        }
+
+        loopGain *= largestRow;
+    }
+
+    if (loopGain >= 1.0)
+        return std::numeric_limits<double>::infinity();
+
+    const double repeats = loopGain > 0.0 ? std::log(static_cast<double>(kTailThreshold)) / std::log(loopGain) : 0.0;
+    return delaySeconds * (std::ceil(repeats) + 1.0);
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::prepare(double newSampleRate, int maxBlockSize, int numChannels)
+{
+    // Coefficients depend on the sample rate, so force a recompute if it changed.
+    if (newSampleRate != sampleRate)
+        currentLowCutHz = currentHighCutHz = -1.0f;
+
+    sampleRate = newSampleRate;
+    numDelayChannels = std::clamp(numChannels, 1, kMaxChannels);
+    numLineChannels = std::max(2, (numDelayChannels + 1) & ~1);
+
+    // Chunks never straddle the longest delay, so the block size doesn't
+    // need to be added to the delay line length.
+    (void) maxBlockSize;
+
+    // Nothing is handed over across a prepare(); the line is settled here.
+    delete pendingLine.exchange(nullptr);
+    delete retiredLine.exchange(nullptr);
+    copyingLine = nullptr;
+
+    maxDelayFrames = static_cast<int>(std::ceil(sampleRate * (kMaxDelayMs / 1000.0)));
+    const double reservedRate = std::max(sampleRate, kPreallocatedSampleRate);
+    const int reservedFrames = static_cast<int>(std::ceil(reservedRate * (kReservedDelayMs / 1000.0))) + kDelayLineMargin;
+
+    // The kernels run channels in pairs or wider groups, so a mono line
+    // still holds two channels.
+    if (delayLine.getCapacity() < reservedFrames || delayLine.getNumChannels() != numLineChannels)
+        delayLine.prepare(reservedFrames, numLineChannels, delayLine.getStorage());
+
+    // Reads reach only as far back as the delays need, however much room
+    // the line has.
+    readableFrames = std::min(delayLine.getCapacity(),
+                              static_cast<int>(std::ceil(sampleRate * (kReservedDelayMs / 1000.0))) + kDelayLineMargin);
+
+    requestedFrames.store(0, std::memory_order_relaxed);
+    requestedStorage.store(static_cast<int>(delayLine.getStorage()), std::memory_order_relaxed);
+    lineFrames.store(delayLine.getCapacity(), std::memory_order_relaxed);
+    lineStorage.store(static_cast<int>(delayLine.getStorage()), std::memory_order_relaxed);
+    lineChannels.store(numLineChannels, std::memory_order_relaxed);
+    updateMaximumDelay();
+
+    const size_t chunkValues = static_cast<size_t>(kMaxChunkFrames) * static_cast<size_t>(numLineChannels);
+    const int maxFeedbackLatency = oversampling::getLatencySamples(Oversampling::x4) + diffusion::getLatencySamples(sampleRate);
+    writeScratch.assign(static_cast<size_t>(kMaxChunkFrames + maxFeedbackLatency + kWriteScratchSlackFrames) * numLineChannels, 0.0f);
+    writeOffset = 0;
+    windowScratch.assign(static_cast<size_t>(kMaxWindowFrames) * numLineChannels, 0.0f);
+    delayedScratch.assign(chunkValues, 0.0f);
+    feedbackScratch.assign(chunkValues, 0.0f);
+    routedScratch.assign(chunkValues, 0.0f);
+    tapScratch.assign(chunkValues * kMaxTaps, 0.0f);
+    discardScratch.assign(static_cast<size_t>(kMaxChunkFrames), 0.0f);
+    silenceScratch.assign(static_cast<size_t>(kMaxChunkFrames), 0.0f);
+    meter.prepare(delayLine.getCapacity());
+
+    // Room for a region per group at the narrowest kernel width.
+    const int numGroups = numLineChannels / 2;
+    const int regionFrames = diffusion::getRegionFrames(sampleRate);
+    diffusionArena.assign(static_cast<size_t>(numGroups * regionFrames), DiffuserFrame<Sample> {});
+
+    for (int group = 0; group < kMaxChannelGroups; ++group)
+        diffusers[group].prepare(group < numGroups ? diffusionArena.data() + group * regionFrames : nullptr, sampleRate);
+
+    // The held frames were dropped with writeScratch; reset() turns
+    // diffusion back on if it is set.
+    diffusionActive = false;
+    feedbackLatency = oversampling::getLatencySamples(activeOversampling);
+    updateMinimumDelay();
+
+    for (int tap = 0; tap < kMaxTaps; ++tap)
+    {
+        tapTimeSmoothed[tap].reset(sampleRate, kSmoothingSeconds);
+        tapGainSmoothed[tap].reset(sampleRate, kSmoothingSeconds);
+        tapPanSmoothed[tap].reset(sampleRate, kSmoothingSeconds);
+        tapSendSmoothed[tap].reset(sampleRate, kSmoothingSeconds);
+    }
+
+    feedbackSmoothed.reset(sampleRate, kSmoothingSeconds);
+    mixSmoothed.reset(sampleRate, kSmoothingSeconds);
+    outputSmoothed.reset(sampleRate, kSmoothingSeconds);
+    lowCutSmoothed.reset(sampleRate, kSmoothingSeconds);
+    highCutSmoothed.reset(sampleRate, kSmoothingSeconds);
+    modulationDepthSmoothed.reset(sampleRate, kSmoothingSeconds);
+    modulationDriftSmoothed.reset(sampleRate, kSmoothingSeconds);
+    modulationSpreadSmoothed.reset(sampleRate, kSmoothingSeconds);
+    diffusionSmoothed.reset(sampleRate, kSmoothingSeconds);
+    diffusionSizeSmoothed.reset(sampleRate, kSmoothingSeconds);
+}
+
+template <typename Sample>
+BasicEchoEngine<Sample>::~BasicEchoEngine()
+{
+    delete pendingLine.load();
+    delete retiredLine.load();
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::release()
+{
+    delete pendingLine.exchange(nullptr);
+    delete retiredLine.exchange(nullptr);
+    copyingLine = nullptr;
+}
+
+template <typename Sample>
+bool BasicEchoEngine<Sample>::updateDelayLine()
+{
+    // One hand-over at a time. Once the audio thread has cleared
+    // pendingLine it has also returned the old storage and published the
+    // new line's size, so both can be read safely below.
+    if (pendingLine.load(std::memory_order_acquire) != nullptr)
+        return false;
+
+    delete retiredLine.exchange(nullptr, std::memory_order_acquire);
+
+    const int currentFrames = lineFrames.load(std::memory_order_relaxed);
+    const int wantedFrames = requestedFrames.load(std::memory_order_relaxed);
+    const int wantedStorage = requestedStorage.load(std::memory_order_relaxed);
+
+    if (currentFrames == 0 || (wantedFrames <= currentFrames && wantedStorage == lineStorage.load(std::memory_order_relaxed)))
+        return false;
+
+    // Lines only grow, so going back to a short delay keeps the memory.
+    auto* line = new DelayLine<Sample>();
+    line->prepare(std::max(wantedFrames, currentFrames), lineChannels.load(std::memory_order_relaxed),
+                  static_cast<DelayStorage>(wantedStorage));
+    pendingLine.store(line, std::memory_order_release);
+    return true;
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::adoptPendingLine(int numFrames) noexcept
+{
+    DelayLine<Sample>* line = pendingLine.load(std::memory_order_acquire);
+
+    if (line == nullptr)
+        return;
+
+    // The old line is copied over a few blocks, a slice at a time, and
+    // stays in use until the copy has caught up with its write head.
+    if (copyingLine != line)
+    {
+        line->beginCopy(delayLine);
+        copyingLine = line;
+    }
+
+    if (! line->continueCopy(delayLine, numFrames + kLineCopyFrames, feedbackLatency))
+        return;
+
+    copyingLine = nullptr;
+
+    const int oldCapacity = delayLine.getCapacity();
+    delayLine.swap(*line);
+
+    if (framesSinceAudibleWrite >= oldCapacity)
+        framesSinceAudibleWrite = delayLine.getCapacity();
+
+    updateMaximumDelay();
+    meter.setMaximumDelay(delayLine.getCapacity());
+
+    lineFrames.store(delayLine.getCapacity(), std::memory_order_relaxed);
+    lineStorage.store(static_cast<int>(delayLine.getStorage()), std::memory_order_relaxed);
+    retiredLine.store(line, std::memory_order_release);
+    pendingLine.store(nullptr, std::memory_order_release);
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::requestDelayLine(const EchoParameters& params, bool synced) noexcept
+{
+    const int numTaps = std::clamp(params.numTaps, 1, kMaxTaps);
+    float longestMs = 0.0f;
+
+    for (int tap = 0; tap < numTaps; ++tap)
+    {
+        const float timeMs = synced ? getSyncTimeSeconds(tap == 0 ? params.syncDivision : params.taps[tap].syncDivision,
+                                                         params.hostBpm) * 1000.0f
+                                    : (tap == 0 ? params.timeMs : params.taps[tap].timeMs);
+        longestMs = std::max(longestMs, timeMs);
+    }
+
+    longestMs += std::clamp(params.modulation.depthMs, 0.0f, modulation::kMaxDepthMs);
+
+    const float longestFrames = std::ceil(std::min(longestMs, static_cast<float>(kMaxDelayMs)) / 1000.0f
+                                          * static_cast<float>(sampleRate));
+    const int wantedFrames = static_cast<int>(longestFrames) + kDelayLineMargin;
+
+    // Whatever fits in the line is available straight away.
+    if (wantedFrames > readableFrames && readableFrames < delayLine.getCapacity())
+    {
+        readableFrames = std::min(wantedFrames, delayLine.getCapacity());
+        updateMaximumDelay();
+    }
+
+    requestedFrames.store(wantedFrames, std::memory_order_relaxed);
+    requestedStorage.store(static_cast<int>(params.delayStorage), std::memory_order_relaxed);
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::updateMaximumDelay() noexcept
+{
+    maxDelaySamples = static_cast<float>(std::min(maxDelayFrames, readableFrames - kDelayLineMargin));
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::reset(const EchoParameters& params)
+{
+    delayLine.clear();
+    copyingLine = nullptr;
+    std::fill(writeScratch.begin(), writeScratch.end(), 0.0f);
+    writeOffset = 0;
+    requestDelayLine(params, params.syncEnabled && params.hostBpm > 0.0);
+
+    // Taps left out start silent, so adding one later fades it in.
+    runningTaps = std::clamp(params.numTaps, 1, kMaxTaps);
+
+    for (int tap = 0; tap < kMaxTaps; ++tap)
+    {
+        const TapParameters& tapParams = params.taps[tap];
+        tapTimeSmoothed[tap].setCurrentAndTargetValue(tap == 0 ? params.timeMs : tapParams.timeMs);
+        tapGainSmoothed[tap].setCurrentAndTargetValue(tap < runningTaps ? std::clamp(tapParams.gain, 0.0f, 1.0f) : 0.0f);
+        tapPanSmoothed[tap].setCurrentAndTargetValue(std::clamp(tapParams.pan, -1.0f, 1.0f));
+        tapSendSmoothed[tap].setCurrentAndTargetValue(tap < runningTaps ? std::clamp(tapParams.feedbackSend, 0.0f, 1.0f) : 0.0f);
+    }
+
+    feedbackSmoothed.setCurrentAndTargetValue(params.feedback);
+    mixSmoothed.setCurrentAndTargetValue(params.mix);
+    outputSmoothed.setCurrentAndTargetValue(decibelsToGain(params.outputDb));
+
+    lowCutSmoothed.setCurrentAndTargetValue(params.lowCutHz);
+    highCutSmoothed.setCurrentAndTargetValue(params.highCutHz);
+    setFilterSlope(params.filterSlope);
+    setFilterCutoffs(params.lowCutHz, params.highCutHz);
+
+    modulationDepthSmoothed.setCurrentAndTargetValue(std::clamp(params.modulation.depthMs, 0.0f, modulation::kMaxDepthMs));
+    modulationDriftSmoothed.setCurrentAndTargetValue(std::clamp(params.modulation.drift, 0.0f, 1.0f));
+    modulationSpreadSmoothed.setCurrentAndTargetValue(std::clamp(params.modulation.spread, 0.0f, 1.0f));
+    setModulationTargets(params.modulation, params.hostBpm);
+    modulationLfo.reset();
+    advanceModulation(0, nullptr);
+
+    resetChannelGroups();
+
+    for (auto& state : allpassState)
+        std::fill(std::begin(state), std::end(state), 0.0f);
+
+    diffusionSmoothed.setCurrentAndTargetValue(std::clamp(params.diffusion.amount, 0.0f, 1.0f));
+    diffusionSizeSmoothed.setCurrentAndTargetValue(std::clamp(params.diffusion.size, 0.0f, 1.0f));
+    setDiffusionSize(diffusionSizeSmoothed.getCurrentValue());
+    diffusionActive = diffusionSmoothed.getCurrentValue() > 0.0f;
+    updateFeedbackLatency();
+
+    // The cleared line is silent, so the engine may sleep straight away.
+    framesSinceAudibleWrite = delayLine.getCapacity();
+    asleep = false;
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setOversampling(Oversampling mode) noexcept
+{
+    if (mode == activeOversampling)
+        return;
+
+    // Start the new filter chain from silence rather than stale history.
+    activeOversampling = mode;
+
+    for (auto& oversampler : oversamplers)
+        oversampler.reset();
+
+    updateFeedbackLatency();
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setDiffusion(const DiffusionParameters& settings) noexcept
+{
+    const float amount = std::clamp(settings.amount, 0.0f, 1.0f);
+    diffusionSmoothed.setTargetValue(amount);
+    diffusionSizeSmoothed.setTargetValue(std::clamp(settings.size, 0.0f, 1.0f));
+
+    const bool active = amount > 0.0f || diffusionSmoothed.getCurrentValue() > 0.0f;
+
+    if (active == diffusionActive)
+        return;
+
+    // The network comes in as a plain delay, its coefficient fading up from
+    // 0, so it starts from silence rather than from whatever it held when it
+    // last went out.
+    diffusionActive = active;
+
+    if (active)
+    {
+        for (auto& diffuser : diffusers)
+            diffuser.clear();
+
+        setDiffusionSize(diffusionSizeSmoothed.getCurrentValue());
+    }
+
+    updateFeedbackLatency();
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setDiffusionSize(float size) noexcept
+{
+    for (auto& diffuser : diffusers)
+        diffuser.setSize(sampleRate, size);
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::updateFeedbackLatency() noexcept
+{
+    const int latency = oversampling::getLatencySamples(activeOversampling)
+                      + (diffusionActive ? diffusion::getLatencySamples(sampleRate) : 0);
+
+    if (latency == feedbackLatency)
+        return;
+
+    // The frames held back for feedback move with the feedback head: store
+    // the old ones and fetch the new ones from the line. A line copy in
+    // progress may have taken frames that are held from now on, so it
+    // starts again.
+    copyingLine = nullptr;
+    const int writePosition = delayLine.getWritePosition();
+    delayLine.write(writePosition - feedbackLatency, getFeedbackFrames(), feedbackLatency);
+    feedbackLatency = latency;
+    writeOffset = 0;
+    delayLine.read(writePosition - feedbackLatency, feedbackLatency, getFeedbackFrames());
+
+    updateMinimumDelay();
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setInterpolation(Interpolation mode) noexcept
+{
+    if (mode == activeInterpolation)
+        return;
+
+    activeInterpolation = mode;
+
+    for (auto& state : allpassState)
+        std::fill(std::begin(state), std::end(state), 0.0f);
+
+    updateMinimumDelay();
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::updateMinimumDelay() noexcept
+{
+    minDelaySamples = static_cast<float>(1 + feedbackLatency + interpolation::getLookahead(activeInterpolation));
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setFilterCutoffs(float lowCutHz, float highCutHz) noexcept
+{
+    // Cheap enough to run every sub-block while a cutoff sweeps.
+    if (lowCutHz != currentLowCutHz)
+    {
+        currentLowCutHz = lowCutHz;
+        lowCutFilters[0].setCutoff(sampleRate, lowCutHz, activeFilterSlope);
+
+        for (auto& filter : lowCutFilters)
+            filter.copyCoefficients(lowCutFilters[0]);
+    }
+
+    if (highCutHz != currentHighCutHz)
+    {
+        currentHighCutHz = highCutHz;
+        highCutFilters[0].setCutoff(sampleRate, highCutHz, activeFilterSlope);
+
+        for (auto& filter : highCutFilters)
+            filter.copyCoefficients(highCutFilters[0]);
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setFilterSlope(FilterSlope slope) noexcept
+{
+    if (slope == activeFilterSlope)
+        return;
+
+    // The damping differs per slope, so the coefficients are redone; a
+    // second stage coming in starts from silence rather than stale state.
+    activeFilterSlope = slope;
+    currentLowCutHz = currentHighCutHz = -1.0f;
+
+    for (int group = 0; group < kMaxChannelGroups; ++group)
+    {
+        lowCutFilters[group].resetStage(1);
+        highCutFilters[group].resetStage(1);
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setModulationTargets(const ModulationParameters& settings, double hostBpm) noexcept
+{
+    modulationDepthSmoothed.setTargetValue(std::clamp(settings.depthMs, 0.0f, modulation::kMaxDepthMs));
+    modulationDriftSmoothed.setTargetValue(std::clamp(settings.drift, 0.0f, 1.0f));
+    modulationSpreadSmoothed.setTargetValue(std::clamp(settings.spread, 0.0f, 1.0f));
+
+    // A rate change only changes how fast the phase moves, so it needs no smoothing.
+    const double rateHz = settings.syncEnabled && hostBpm > 0.0
+                        ? 1.0 / getSyncTimeSeconds(settings.syncDivision, hostBpm)
+                        : static_cast<double>(std::clamp(settings.rateHz, modulation::kMinRateHz, modulation::kMaxRateHz));
+    modulationCyclesPerFrame = rateHz / sampleRate;
+}
+
+template <typename Sample>
+bool BasicEchoEngine<Sample>::isModulating() const noexcept
+{
+    return modulationDepthSmoothed.isSmoothing() || modulationDepthSmoothed.getTargetValue() > 0.0f;
+}
+
+template <typename Sample>
+int BasicEchoEngine<Sample>::getModulationChunkFrames() const noexcept
+{
+    // The LFOs are followed in straight lines of at most 1/64 cycle, within
+    // 0.12 % of the depth, so slow modulation keeps long chunks.
+    const double frames = 1.0 / (kModulationSegmentsPerCycle * modulationCyclesPerFrame);
+    return static_cast<int>(std::clamp(frames, static_cast<double>(kControlBlockSize), static_cast<double>(kMaxChunkFrames)));
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::advanceModulation(int numFrames, ControlRamp* ramps) noexcept
+{
+    // The LFOs are evaluated once per chunk, at its last frame; ramps join
+    // that to where the previous chunk ended.
+    modulationLfo.advance(modulationCyclesPerFrame, numFrames);
+
+    const float depthSamples = modulationDepthSmoothed.skip(numFrames) * static_cast<float>(sampleRate / 1000.0);
+    const float drift = modulationDriftSmoothed.skip(numFrames);
+    const double phaseSpacing = static_cast<double>(modulationSpreadSmoothed.skip(numFrames)) / numDelayChannels;
+
+    for (int channel = 0; channel < numLineChannels; ++channel)
+    {
+        const float offset = depthSamples * modulationLfo.getValue(phaseSpacing * channel, drift);
+
+        if (ramps != nullptr)
+        {
+            const float step = (offset - modulationOffsets[channel]) / static_cast<float>(numFrames);
+            ramps[channel] = { modulationOffsets[channel] + step, step };
+        }
+
+        modulationOffsets[channel] = offset;
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::resetChannelGroups() noexcept
+{
+    for (int group = 0; group < kMaxChannelGroups; ++group)
+    {
+        lowCutFilters[group].reset();
+        highCutFilters[group].reset();
+        oversamplers[group].reset();
+        diffusers[group].clear();
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setKernelIsa(KernelIsa isa) noexcept
+{
+    kernels = &getKernels<Sample>(isa);
+    resetChannelGroups();
+}
+
+template <typename Sample>
+bool BasicEchoEngine<Sample>::canSleep(Sample* const* channels, int numInputChannels, int numSamples) const noexcept
+{
+    if (framesSinceAudibleWrite < readableFrames)
+        return false;
+
+    for (int channel = 0; channel < numInputChannels; ++channel)
+        if (getPeak(channels[channel], numSamples) >= kSilenceThreshold)
+            return false;
+
+    return true;
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::processAsleep(Sample* const* channels, int numChannels, int numInputChannels,
+                               int numSamples) noexcept
+{
+    // The delay line, filters and oversampler are left exactly as they were,
+    // so processing resumes from that state when the input returns. Ramps in
+    // progress still run to time, to resume where they would have been.
+    for (int tap = 0; tap < kMaxTaps; ++tap)
+    {
+        tapTimeSmoothed[tap].skip(numSamples);
+        tapGainSmoothed[tap].skip(numSamples);
+        tapPanSmoothed[tap].skip(numSamples);
+        tapSendSmoothed[tap].skip(numSamples);
+    }
+
+    feedbackSmoothed.skip(numSamples);
+    setFilterCutoffs(lowCutSmoothed.skip(numSamples), highCutSmoothed.skip(numSamples));
+    diffusionSmoothed.skip(numSamples);
+
+    if (diffusionSizeSmoothed.isSmoothing())
+        setDiffusionSize(diffusionSizeSmoothed.skip(numSamples));
+
+    if (isModulating())
+        advanceModulation(numSamples, nullptr);
+
+    const float dryGain = std::cos(mixSmoothed.skip(numSamples) * kHalfPi) * outputSmoothed.skip(numSamples);
+
+    // Backwards, so a mono input in channel 0 is read before it's overwritten.
+    for (int channel = numChannels; --channel >= 0;)
+    {
+        const Sample* input = channels[channel < numInputChannels ? channel : 0];
+        Sample* output = channels[channel];
+
+        for (int i = 0; i < numSamples; ++i)
+            output[i] = input[i] * dryGain;
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::trackWrittenLevel(int numFrames) noexcept
+{
+    // The chunk's input went in feedbackLatency frames after the frames it
+    // finished, so every frame is checked once as input and once final.
+    const Sample* frames = getFeedbackFrames();
+    const int inputStart = std::max(numFrames, feedbackLatency);
+    const bool audible = getPeak(frames, numFrames * numLineChannels) >= kSilenceThreshold
+                      || getPeak(frames + inputStart * numLineChannels,
+                                 std::min(numFrames, feedbackLatency) * numLineChannels) >= kSilenceThreshold;
+    framesSinceAudibleWrite = audible ? 0 : std::min(framesSinceAudibleWrite + numFrames, delayLine.getCapacity());
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::commitWrittenFrames(int numFrames) noexcept
+{
+    delayLine.write(delayLine.getWritePosition() - feedbackLatency, getFeedbackFrames(), numFrames);
+    writeOffset += numFrames;
+
+    // The held frames go back to the start once another chunk wouldn't fit
+    // after them.
+    if (static_cast<size_t>((writeOffset + feedbackLatency + kMaxChunkFrames) * numLineChannels) > writeScratch.size())
+    {
+        const Sample* const held = getFeedbackFrames();
+        std::copy(held, held + feedbackLatency * numLineChannels, writeScratch.data());
+        writeOffset = 0;
+    }
+}
+
+template <typename Sample>
+float BasicEchoEngine<Sample>::delayMsToSamples(float delayMs) const noexcept
+{
+    return std::clamp((delayMs / 1000.0f) * static_cast<float>(sampleRate), minDelaySamples, maxDelaySamples);
+}
+
+template <typename Sample>
+bool BasicEchoEngine<Sample>::isSmoothing(bool synced) const noexcept
+{
+    for (int tap = 0; tap < runningTaps; ++tap)
+        if ((! synced && tapTimeSmoothed[tap].isSmoothing()) || tapGainSmoothed[tap].isSmoothing()
+            || tapPanSmoothed[tap].isSmoothing() || tapSendSmoothed[tap].isSmoothing())
+            return true;
+
+    return feedbackSmoothed.isSmoothing()
+        || mixSmoothed.isSmoothing() || outputSmoothed.isSmoothing()
+        || lowCutSmoothed.isSmoothing() || highCutSmoothed.isSmoothing()
+        || (diffusionActive && (diffusionSmoothed.isSmoothing() || diffusionSizeSmoothed.isSmoothing()));
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::setTapTargets(const EchoParameters& params, bool synced) noexcept
+{
+    const int numTaps = std::clamp(params.numTaps, 1, kMaxTaps);
+
+    for (int tap = 0; tap < kMaxTaps; ++tap)
+    {
+        const TapParameters& tapParams = params.taps[tap];
+        const float timeMs = tap == 0 ? params.timeMs : tapParams.timeMs;
+        const bool active = tap < numTaps;
+
+        // A tap coming in starts at its own time and fades in from silence.
+        if (active && tap >= runningTaps)
+        {
+            tapTimeSmoothed[tap].setCurrentAndTargetValue(timeMs);
+            std::fill(std::begin(allpassState[tap]), std::end(allpassState[tap]), 0.0f);
+        }
+
+        tapTimeSmoothed[tap].setTargetValue(timeMs);
+        tapGainSmoothed[tap].setTargetValue(active ? std::clamp(tapParams.gain, 0.0f, 1.0f) : 0.0f);
+        tapPanSmoothed[tap].setTargetValue(std::clamp(tapParams.pan, -1.0f, 1.0f));
+        tapSendSmoothed[tap].setTargetValue(active ? std::clamp(tapParams.feedbackSend, 0.0f, 1.0f) : 0.0f);
+
+        if (synced)
+            tapSyncTimeMs[tap] = getSyncTimeSeconds(tap == 0 ? params.syncDivision : tapParams.syncDivision,
+                                                    params.hostBpm) * 1000.0f;
+    }
+
+    // Taps taken out keep being read until they have faded out.
+    runningTaps = numTaps;
+
+    for (int tap = kMaxTaps; --tap >= numTaps;)
+    {
+        if (tapGainSmoothed[tap].getCurrentValue() != 0.0f || tapSendSmoothed[tap].getCurrentValue() != 0.0f)
+        {
+            runningTaps = tap + 1;
+            break;
+        }
+    }
+}
+
+template <typename Sample>
+int BasicEchoEngine<Sample>::getChunkLength(int remaining, int maxFrames, bool synced) const noexcept
+{
+    const int numFrames = std::min(remaining, maxFrames);
+
+    // A chunk must not read anything it writes itself, including feedback
+    // written feedbackLatency frames back and the interpolator's lookahead.
+    // The delay ramps linearly, so its shortest value is at one end of the
+    // ramp; keep one frame of headroom for rounding along the ramp.
+    float shortestDelayMs = static_cast<float>(kMaxDelayMs);
+
+    for (int tap = 0; tap < runningTaps; ++tap)
+        shortestDelayMs = std::min(shortestDelayMs, synced ? tapSyncTimeMs[tap]
+                                                           : std::min(tapTimeSmoothed[tap].getCurrentValue(),
+                                                                      tapTimeSmoothed[tap].getTargetValue()));
+
+    // Modulation can shorten every delay by up to its depth.
+    if (isModulating())
+        shortestDelayMs -= std::max(modulationDepthSmoothed.getCurrentValue(), modulationDepthSmoothed.getTargetValue());
+
+    const int shortestDelay = static_cast<int>(delayMsToSamples(shortestDelayMs)) - 1 - feedbackLatency
+                            - interpolation::getLookahead(activeInterpolation);
+
+    return std::max(1, std::min(numFrames, shortestDelay));
+}
+
+template <typename Sample>
+typename BasicEchoEngine<Sample>::ControlBlock BasicEchoEngine<Sample>::advanceControls(int numFrames, bool synced) noexcept
+{
+    ControlBlock controls;
+
+    for (int tap = 0; tap < runningTaps; ++tap)
+    {
+        if (synced)
+        {
+            controls.delaySamples[tap] = { delayMsToSamples(tapSyncTimeMs[tap]), 0.0f };
+        }
+        else
+        {
+            // Clamping is applied at the ends of the ramp; the clamp range is
+            // convex, so every frame in between stays inside it too.
+            const ControlRamp timeMs = advanceRamp(tapTimeSmoothed[tap], numFrames);
+            controls.delaySamples[tap] = makeRamp(delayMsToSamples(timeMs.first),
+                                                  delayMsToSamples(timeMs.at(numFrames - 1)), numFrames);
+        }
+
+        // Like the mix curve, the pan law is evaluated at the chunk ends only.
+        const ControlRamp gain = advanceRamp(tapGainSmoothed[tap], numFrames);
+        const ControlRamp pan = advanceRamp(tapPanSmoothed[tap], numFrames);
+        float firstLeft, firstRight, lastLeft, lastRight;
+        getTapGains(gain.first, pan.first, firstLeft, firstRight);
+        getTapGains(gain.at(numFrames - 1), pan.at(numFrames - 1), lastLeft, lastRight);
+        controls.gain[tap] = gain;
+        controls.leftGain[tap] = makeRamp(firstLeft, lastLeft, numFrames);
+        controls.rightGain[tap] = makeRamp(firstRight, lastRight, numFrames);
+        controls.feedbackSend[tap] = advanceRamp(tapSendSmoothed[tap], numFrames);
+    }
+
+    const auto isUnity = [](ControlRamp ramp) { return ramp.first == 1.0f && ramp.step == 0.0f; };
+    controls.direct = runningTaps == 1 && isUnity(controls.leftGain[0]) && isUnity(controls.rightGain[0])
+                   && isUnity(controls.feedbackSend[0]);
+
+    controls.feedbackGain = advanceRamp(feedbackSmoothed, numFrames);
+    controls.outputGain = advanceRamp(outputSmoothed, numFrames);
+
+    // The constant-power curve is evaluated at both ends of the chunk only.
+    const ControlRamp mix = advanceRamp(mixSmoothed, numFrames);
+    const float firstMix = mix.first * kHalfPi;
+    const float lastMix = mix.at(numFrames - 1) * kHalfPi;
+    controls.dryGain = makeRamp(std::cos(firstMix), std::cos(lastMix), numFrames);
+    controls.wetGain = makeRamp(std::sin(firstMix), std::sin(lastMix), numFrames);
+
+    controls.modulated = isModulating();
+
+    if (controls.modulated)
+        advanceModulation(numFrames, controls.modulationSamples);
+
+    // Coefficients are held for the chunk at the value its end reaches.
+    if (lowCutSmoothed.isSmoothing() || highCutSmoothed.isSmoothing())
+        setFilterCutoffs(lowCutSmoothed.skip(numFrames), highCutSmoothed.skip(numFrames));
+
+    // So are the diffusion coefficient and delays; the delays move a few
+    // frames per chunk while the size is smoothed.
+    controls.diffusion = diffusionSmoothed.skip(numFrames) * diffusion::kMaxCoefficient;
+
+    if (diffusionSizeSmoothed.isSmoothing())
+        setDiffusionSize(diffusionSizeSmoothed.skip(numFrames));
+
+    return controls;
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::readTaps(int numFrames, const ControlBlock& controls) noexcept
+{
+    if (controls.direct)
+    {
+        readDelayedChunk(numFrames, controls.delaySamples[0], controls, delayedScratch.data(), allpassState[0]);
+        return;
+    }
+
+    for (int tap = 0; tap < runningTaps; ++tap)
+        readDelayedChunk(numFrames, controls.delaySamples[tap], controls,
+                         tapScratch.data() + tap * numLineChannels * kMaxChunkFrames, allpassState[tap]);
+
+    mixTaps(numFrames, controls);
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::mixTaps(int numFrames, const ControlBlock& controls) noexcept
+{
+    // One pass per tap and control over contiguous runs, which the compiler
+    // vectorises; the sums are the wet signal and the feedback source.
+    for (int channel = 0; channel < numLineChannels; ++channel)
+    {
+        Sample* wet = delayedScratch.data() + channel * kMaxChunkFrames;
+        Sample* feedback = feedbackScratch.data() + channel * kMaxChunkFrames;
+        const ControlRamp* gains = channel == 0 ? controls.leftGain
+                                 : channel == 1 ? controls.rightGain
+                                 : controls.gain;
+
+        std::fill(wet, wet + numFrames, Sample(0));
+        std::fill(feedback, feedback + numFrames, Sample(0));
+
+        for (int tap = 0; tap < runningTaps; ++tap)
+        {
+            const Sample* source = tapScratch.data() + (tap * numLineChannels + channel) * kMaxChunkFrames;
+            addRamped(wet, source, gains[tap], numFrames);
+            addRamped(feedback, source, controls.feedbackSend[tap], numFrames);
+        }
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::readDelayedChunk(int numFrames, ControlRamp delay, const ControlBlock& controls,
+                                               Sample* destination, Sample* state) noexcept
+{
+    if (controls.modulated)
+    {
+        const ControlRamp* offsets = controls.modulationSamples;
+
+        switch (activeInterpolation)
+        {
+            case Interpolation::hermite: readModulatedChunk<Interpolation::hermite>(numFrames, delay, offsets, destination, state); break;
+            case Interpolation::lagrange: readModulatedChunk<Interpolation::lagrange>(numFrames, delay, offsets, destination, state); break;
+            case Interpolation::allpass: readModulatedChunk<Interpolation::allpass>(numFrames, delay, offsets, destination, state); break;
+            case Interpolation::linear:
+            default: readModulatedChunk<Interpolation::linear>(numFrames, delay, offsets, destination, state); break;
+        }
+
+        return;
+    }
+
+    switch (activeInterpolation)
+    {
+        case Interpolation::hermite: readDelayedChunk<Interpolation::hermite>(numFrames, delay, destination, state); break;
+        case Interpolation::lagrange: readDelayedChunk<Interpolation::lagrange>(numFrames, delay, destination, state); break;
+        case Interpolation::allpass: readDelayedChunk<Interpolation::allpass>(numFrames, delay, destination, state); break;
+        case Interpolation::linear:
+        default: readDelayedChunk<Interpolation::linear>(numFrames, delay, destination, state); break;
+    }
+}
+
+template <typename Sample>
+template <Interpolation mode>
+void BasicEchoEngine<Sample>::readConstantDelay(int numFrames, float delaySamples, Sample* destinations, Sample* state) noexcept
+{
+    const int writePosition = delayLine.getWritePosition();
+
+    // Constant delay: the frames read are one run starting at the oldest
+    // point the first output needs, so every mode is a short filter over a
+    // contiguous window.
+    int oldest = 0;
+    int windowFrames = 0;
+    Sample frac = 0;
+    float coefficient = 0.0f;
+
+    if constexpr (mode == Interpolation::allpass)
+    {
+        int tap = 0;
+        interpolation::getAllpassTap(delaySamples, tap, coefficient);
+        oldest = tap + 1;
+        windowFrames = numFrames + 1;
+    }
+    else
+    {
+        const int delaySamplesInt = static_cast<int>(delaySamples);
+        frac = static_cast<Sample>(delaySamples - static_cast<float>(delaySamplesInt));
+        // Two points for linear; four, one of them newer, otherwise.
+        oldest = delaySamplesInt + 1 + interpolation::getLookahead(mode);
+        windowFrames = numFrames + 1 + 2 * interpolation::getLookahead(mode);
+    }
+
+    const Sample* window = delayLine.getFrames(writePosition - oldest, windowFrames, windowScratch.data());
+
+    for (int channel = 0; channel < numLineChannels; ++channel)
+    {
+        const Sample* source = window + channel;
+        Sample* destination = destinations + channel * kMaxChunkFrames;
+
+        if constexpr (mode == Interpolation::linear)
+        {
+            for (int i = 0; i < numFrames; ++i)
+            {
+                const Sample sampleB = source[i * numLineChannels];
+                const Sample sampleA = source[(i + 1) * numLineChannels];
+                destination[i] = sampleA + frac * (sampleB - sampleA);
+            }
+        }
+        else if constexpr (mode == Interpolation::allpass)
+        {
+            Sample output = state[channel];
+
+            for (int i = 0; i < numFrames; ++i)
+            {
+                const Sample older = source[i * numLineChannels];
+                const Sample newer = source[(i + 1) * numLineChannels];
+                output = coefficient * (newer - output) + older;
+                destination[i] = output;
+            }
+
+            state[channel] = output;
+        }
+        else
+        {
+            Sample weights[4];
+            interpolation::getWeights<mode>(frac, weights);
+
+            for (int i = 0; i < numFrames; ++i)
+                destination[i] = weights[3] * source[i * numLineChannels]
+                               + weights[2] * source[(i + 1) * numLineChannels]
+                               + weights[1] * source[(i + 2) * numLineChannels]
+                               + weights[0] * source[(i + 3) * numLineChannels];
+        }
+    }
+
+}
+
+template <typename Sample>
+template <Interpolation mode>
+void BasicEchoEngine<Sample>::readDelayedChunk(int numFrames, ControlRamp delay, Sample* destination, Sample* state) noexcept
+{
+    const int writePosition = delayLine.getWritePosition();
+
+    if (delay.step == 0.0f)
+    {
+        readConstantDelay<mode>(numFrames, delay.first, destination, state);
+        return;
+    }
+
+    Sample frameScratch[4][kMaxChannels];
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const float delaySamples = delay.at(i);
+
+        if constexpr (mode == Interpolation::allpass)
+        {
+            int tap = 0;
+            float coefficient = 0.0f;
+            interpolation::getAllpassTap(delaySamples, tap, coefficient);
+
+            const Sample* newer = delayLine.getFrame(writePosition + i - tap, frameScratch[0]);
+            const Sample* older = delayLine.getFrame(writePosition + i - tap - 1, frameScratch[1]);
+
+            for (int channel = 0; channel < numLineChannels; ++channel)
+            {
+                state[channel] = coefficient * (newer[channel] - state[channel]) + older[channel];
+                destination[channel * kMaxChunkFrames + i] = state[channel];
+            }
+        }
+        else
+        {
+            const int delaySamplesInt = static_cast<int>(delaySamples);
+            const Sample frac = static_cast<Sample>(delaySamples - static_cast<float>(delaySamplesInt));
+
+            const Sample* frameA = delayLine.getFrame(writePosition + i - delaySamplesInt, frameScratch[0]);
+            const Sample* frameB = delayLine.getFrame(writePosition + i - delaySamplesInt - 1, frameScratch[1]);
+
+            if constexpr (mode == Interpolation::linear)
+            {
+                for (int channel = 0; channel < numLineChannels; ++channel)
+                    destination[channel * kMaxChunkFrames + i]
+                        = frameA[channel] + frac * (frameB[channel] - frameA[channel]);
+            }
+            else
+            {
+                const Sample* frameNewer = delayLine.getFrame(writePosition + i - delaySamplesInt + 1, frameScratch[2]);
+                const Sample* frameOlder = delayLine.getFrame(writePosition + i - delaySamplesInt - 2, frameScratch[3]);
+
+                Sample weights[4];
+                interpolation::getWeights<mode>(frac, weights);
+
+                for (int channel = 0; channel < numLineChannels; ++channel)
+                    destination[channel * kMaxChunkFrames + i]
+                        = weights[3] * frameOlder[channel] + weights[2] * frameB[channel]
+                        + weights[1] * frameA[channel] + weights[0] * frameNewer[channel];
+            }
+        }
+    }
+}
+
+template <typename Sample>
+template <Interpolation mode>
+void BasicEchoEngine<Sample>::readModulatedChunk(int numFrames, ControlRamp delay, const ControlRamp* offsets,
+                                                 Sample* destinations, Sample* state) noexcept
+{
+    const int writePosition = delayLine.getWritePosition();
+    const float lastDelay = delay.at(numFrames - 1);
+
+    // Every channel has its own delay, so each is read on its own.
+    for (int channel = 0; channel < numLineChannels; ++channel)
+    {
+        // Clamped at the ends of the ramp, like the tap delays.
+        const float first = std::clamp(delay.first + offsets[channel].first, minDelaySamples, maxDelaySamples);
+        const float last = std::clamp(lastDelay + offsets[channel].at(numFrames - 1), minDelaySamples, maxDelaySamples);
+        const ControlRamp channelDelay = makeRamp(first, last, numFrames);
+        Sample* destination = destinations + channel * kMaxChunkFrames;
+
+        // A slow sweep reads a run only a little longer than the chunk:
+        // gather it once, with two frames of margin for any mode, and index
+        // it like a constant-delay read. Fast time changes sweep too far and
+        // read frame by frame.
+        const int longest = static_cast<int>(std::max(first, last));
+        const int windowFrames = numFrames + longest - static_cast<int>(std::min(first, last)) + 4;
+
+        if (windowFrames <= kMaxWindowFrames)
+        {
+            const Sample* window = delayLine.getFrames(writePosition - longest - 2, windowFrames, windowScratch.data())
+                                 + channel + (longest + 2) * numLineChannels;
+            const int stride = numLineChannels;
+            readRamp<mode>([window, stride](int offset) { return window[offset * stride]; },
+                           channelDelay, numFrames, destination, state[channel]);
+        }
+        else
+        {
+            readRamp<mode>([this, writePosition, channel](int offset) { return delayLine.getSample(writePosition + offset, channel); },
+                           channelDelay, numFrames, destination, state[channel]);
+        }
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::routeFeedback(const Sample** sources, const PingPongRouting& routing, int numChannels,
+                                            int numFrames) noexcept
+{
+    const Sample* unrouted[kMaxChannels];
+    std::copy(sources, sources + numChannels, unrouted);
+
+    if (! routing.useMatrix)
+    {
+        const int rotation = (routing.rotation % numChannels + numChannels) % numChannels;
+
+        for (int to = 0; to < numChannels; ++to)
+            sources[to] = unrouted[(to - rotation + numChannels) % numChannels];
+
+        return;
+    }
+
+    for (int to = 0; to < numChannels; ++to)
+    {
+        const float* gains = routing.matrix[to];
+        int numSources = 0;
+        int lastSource = 0;
+
+        for (int from = 0; from < numChannels; ++from)
+        {
+            if (gains[from] != 0.0f)
+            {
+                ++numSources;
+                lastSource = from;
+            }
+        }
+
+        // A row that only picks one channel is a pointer, like a rotation.
+        if (numSources == 1 && gains[lastSource] == 1.0f)
+        {
+            sources[to] = unrouted[lastSource];
+            continue;
+        }
+
+        Sample* mixed = routedScratch.data() + to * kMaxChunkFrames;
+        std::fill(mixed, mixed + numFrames, Sample(0));
+
+        for (int from = 0; from < numChannels; ++from)
+            if (gains[from] != 0.0f)
+                addRamped(mixed, unrouted[from], { gains[from], 0.0f }, numFrames);
+
+        sources[to] = mixed;
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::processFeedbackChunk(Sample* const* channels, int numChannels, int numInputChannels,
+                                      int startSample, int numFrames, const ControlBlock& controls,
+                                      const PingPongRouting* routing, DriveStage driveStage, float driveGain) noexcept
+{
+    const Sample* feedbackSources[kMaxChannels];
+    const Sample* delayed[kMaxChannels];
+    const Sample* inputs[kMaxChannels];
+    Sample* outputs[kMaxChannels];
+
+    for (int channel = 0; channel < numLineChannels; ++channel)
+    {
+        delayed[channel] = delayedScratch.data() + channel * kMaxChunkFrames;
+        feedbackSources[channel] = controls.direct ? delayed[channel]
+                                                   : feedbackScratch.data() + channel * kMaxChunkFrames;
+
+        // The padding channel of an odd layout runs silence.
+        const bool padding = channel >= numDelayChannels;
+        const int inputChannel = channel < numInputChannels ? channel : 0;
+        inputs[channel] = padding ? silenceScratch.data() : channels[inputChannel] + startSample;
+        outputs[channel] = channel < numChannels ? channels[channel] + startSample : discardScratch.data();
+    }
+
+    if (routing != nullptr && numChannels > 1)
+        routeFeedback(feedbackSources, *routing, numChannels, numFrames);
+
+    FeedbackKernelArgs<Sample> args;
+    args.frameStride = numLineChannels;
+    args.feedbackGain = controls.feedbackGain;
+    args.dryGain = controls.dryGain;
+    args.wetGain = controls.wetGain;
+    args.outputGain = controls.outputGain;
+    args.driveGain = driveGain;
+    args.numFrames = numFrames;
+    args.tanhTable = saturation::getTanhTable();
+    args.diffusion = controls.diffusion;
+
+    // One dispatch per chunk and group picks the variant; the loop itself
+    // has no mode branches.
+    const bool ramping = controls.feedbackGain.step != 0.0f || controls.dryGain.step != 0.0f
+                      || controls.wetGain.step != 0.0f || controls.outputGain.step != 0.0f;
+    const auto& processFeedback = kernels->processFeedback[static_cast<int>(activeOversampling)][static_cast<int>(driveStage)];
+    const int groupLanes = kernels->numLanes;
+
+    // Backwards: a kernel reads all inputs of a frame before writing its
+    // outputs, so a mono input shared in place stays intact as long as the
+    // group holding channel 0 runs last.
+    for (int group = (numLineChannels - 1) / groupLanes; group >= 0; --group)
+    {
+        const int firstChannel = group * groupLanes;
+        const int numLanes = std::min(groupLanes, numLineChannels - firstChannel);
+        bool monoInput = true;
+
+        for (int lane = 0; lane < kMaxKernelLanes; ++lane)
+        {
+            const int channel = firstChannel + std::min(lane, numLanes - 1);
+            args.feedbackSources[lane] = feedbackSources[channel];
+            args.delayed[lane] = delayed[channel];
+            args.inputs[lane] = inputs[channel];
+            args.outputs[lane] = lane < numLanes ? outputs[channel] : discardScratch.data();
+            monoInput = monoInput && inputs[channel] == inputs[firstChannel];
+        }
+
+        // The kernel writes into writeScratch; commitWrittenFrames() moves
+        // the finished frames into the delay line.
+        args.writeFrames = getFeedbackFrames() + feedbackLatency * numLineChannels + firstChannel;
+        args.feedbackFrames = getFeedbackFrames() + firstChannel;
+        args.oversampler = &oversamplers[group];
+        args.lowCut = &lowCutFilters[group];
+        args.highCut = &highCutFilters[group];
+        args.diffuser = &diffusers[group];
+
+        const int variant = (ramping ? kRampingGains : 0) | (monoInput ? kMonoInput : 0)
+                          | (numLanes > 2 ? kAllLanes : 0)
+                          | (activeFilterSlope == FilterSlope::db24 ? kSteepFilters : 0)
+                          | (diffusionActive ? kDiffusion : 0);
+        processFeedback[variant](args);
+    }
+}
+
+template <typename Sample>
+void BasicEchoEngine<Sample>::process(Sample* const* channels, int numChannels, int numInputChannels,
+                         int numSamples, const EchoParameters& params)
+{
+    if (delayLine.isEmpty() || numInputChannels <= 0)
+        return;
+
+    DenormalGuard denormalGuard;
+
+    numChannels = std::min(numChannels, numDelayChannels);
+
+    const float feedbackValue = std::clamp(params.feedback, 0.0f, kFeedbackMax);
+    const float mixValue = std::clamp(params.mix, 0.0f, 1.0f);
+
+    feedbackSmoothed.setTargetValue(feedbackValue);
+    mixSmoothed.setTargetValue(mixValue);
+    outputSmoothed.setTargetValue(decibelsToGain(params.outputDb));
+
+    lowCutSmoothed.setTargetValue(params.lowCutHz);
+    highCutSmoothed.setTargetValue(params.highCutHz);
+    setFilterSlope(params.filterSlope);
+    setModulationTargets(params.modulation, params.hostBpm);
+
+    // Only does work if a cutoff jumped without smoothing or the sample rate changed.
+    if (! lowCutSmoothed.isSmoothing() && ! highCutSmoothed.isSmoothing())
+        setFilterCutoffs(params.lowCutHz, params.highCutHz);
+
+    const bool synced = params.syncEnabled && params.hostBpm > 0.0;
+    adoptPendingLine(numSamples);
+    requestDelayLine(params, synced);
+    setTapTargets(params, synced);
+
+    const float driveGain = decibelsToGain(params.driveDb);
+    const DriveStage driveStage = getDriveStage(params.driveDb, params.driveQuality);
+
+    // A bypassed saturator is linear and needs no oversampling (or its latency).
+    setOversampling(driveStage == DriveStage::bypassed ? Oversampling::off : params.oversampling);
+    setDiffusion(params.diffusion);
+    setInterpolation(params.interpolation);
+
+    const bool metering = meteringEnabled.load(std::memory_order_relaxed);
+    if (metering)
+        meter.beginBlock(channels, numInputChannels, numSamples);
+
+    asleep = canSleep(channels, numInputChannels, numSamples);
+
+    if (asleep)
+    {
+        processAsleep(channels, numChannels, numInputChannels, numSamples);
+
+        if (metering)
+            meter.endBlock(channels, numChannels, numSamples, feedbackSmoothed.getCurrentValue(),
+                           delayMsToSamples(synced ? tapSyncTimeMs[0] : tapTimeSmoothed[0].getCurrentValue()));
+        return;
+    }
+
+    float delaySamples = 0.0f;
+
+    for (int startSample = 0; startSample < numSamples;)
+    {
+        // Nothing moving: run the longest chunks with constant controls.
+        const int maxFrames = isSmoothing(synced) ? kControlBlockSize
+                            : isModulating() ? getModulationChunkFrames()
+                            : kMaxChunkFrames;
+        const int numFrames = getChunkLength(numSamples - startSample, maxFrames, synced);
+        const ControlBlock controls = advanceControls(numFrames, synced);
+
+        readTaps(numFrames, controls);
+        processFeedbackChunk(channels, numChannels, numInputChannels, startSample, numFrames, controls,
+                             params.pingPong ? &params.pingPongRouting : nullptr, driveStage, driveGain);
+        trackWrittenLevel(numFrames);
+
+        if (metering)
+            meter.addWrittenFrames(getFeedbackFrames(), numFrames, numLineChannels);
+
+        commitWrittenFrames(numFrames);
+
+        delaySamples = controls.delaySamples[0].at(numFrames - 1);
+        delayLine.advance(numFrames);
+        startSample += numFrames;
+    }
+
+    if (metering)
+        meter.endBlock(channels, numChannels, numSamples, feedbackSmoothed.getCurrentValue(), delaySamples);
+}
+
+template class BasicEchoEngine<float>;
+template class BasicEchoEngine<double>;
+}
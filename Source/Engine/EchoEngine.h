@@ -0,0 +1,452 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "DelayLine.h"
+#include "Diffusion.h"
+#include "EchoKernel.h"
+#include "Interpolation.h"
+#include "LinearSmoother.h"
+#include "Metering.h"
+#include "Modulation.h"
+#include "Oversampling.h"
+#include "Saturation.h"
+#include "StateVariableFilter.h"
+
+#ifndef ECHO_PREALLOCATE_SAMPLE_RATE
+ #define ECHO_PREALLOCATE_SAMPLE_RATE 96000
+#endif
+
+namespace echo
+{
+/** Most read heads the engine runs on its one delay line. */
+constexpr int kMaxTaps = 8;
+
+/** Most channels one engine processes: enough for 7.1.4 (12) and
+    third-order ambisonics (16).
+*/
+constexpr int kMaxChannels = 16;
+
+/** Settings for one read head. */
+struct TapParameters
+{
+    float timeMs = 400.0f;
+    int syncDivision = 2;
+    float gain = 1.0f;          // 0..1
+    float pan = 0.0f;           // -1 (left) .. 1 (right), a balance between channels 0 and 1
+    float feedbackSend = 1.0f;  // 0..1, how much of this tap goes round the loop
+};
+
+/** Where ping-pong sends the repeats. Channels are numbered as the caller
+    passes them; only the first numChannels rows and columns are used.
+*/
+struct PingPongRouting
+{
+    /** Unless useMatrix is set, each trip round the loop moves the repeats
+        from channel c to channel (c + rotation) mod numChannels. 1 is the
+        classic stereo ping-pong and circles a surround layout.
+    */
+    int rotation = 1;
+
+    /** Feed channel `to` with the sum of matrix[to][from] times the repeats
+        of each channel `from` instead. Rows holding a single 1 cost no more
+        than a rotation.
+    */
+    bool useMatrix = false;
+    float matrix[kMaxChannels][kMaxChannels] = {};
+};
+
+/** Plain-value snapshot of every parameter the engine needs for one block.
+
+    The plugin fills this from its APVTS and the host playhead; headless tools
+    can fill it directly.
+*/
+struct EchoParameters
+{
+    float timeMs = 400.0f;
+    bool syncEnabled = false;
+    int syncDivision = 2;
+    double hostBpm = 0.0;      // <= 0 when the host doesn't provide a tempo
+    float feedback = 0.35f;    // 0..1, clamped to EchoEngine::kFeedbackMax
+    float mix = 0.35f;         // 0..1
+    float lowCutHz = 120.0f;
+    float highCutHz = 8000.0f;
+    FilterSlope filterSlope = FilterSlope::db12;
+    bool pingPong = false;
+    PingPongRouting pingPongRouting;
+    Interpolation interpolation = Interpolation::linear;
+    float driveDb = 6.0f;      // 0 dB bypasses the saturator
+    DriveQuality driveQuality = kDefaultDriveQuality;
+    Oversampling oversampling = Oversampling::off;
+    float outputDb = 0.0f;
+    DelayStorage delayStorage = DelayStorage::full;
+    ModulationParameters modulation;
+    DiffusionParameters diffusion;
+
+    /** Read heads in use, 1..kMaxTaps. The first tap takes its time from
+        timeMs and syncDivision above; taps[0].timeMs and
+        taps[0].syncDivision are ignored.
+    */
+    int numTaps = 1;
+    TapParameters taps[kMaxTaps];
+};
+
+/** The echo DSP: delay line, feedback filtering, drive and dry/wet mix.
+
+    Works on raw channel pointers in place and has no JUCE dependency, so it
+    can be driven by the plugin wrapper as well as by headless tools.
+
+    Runs up to kMaxChannels channels. They share one interleaved delay line,
+    padded to an even channel count, and go through the feedback kernel in
+    groups of EchoKernels::numLanes, one channel per SIMD lane, with the
+    filter and oversampler state of each group laid out in lanes the same
+    way.
+
+    Templated on the audio sample type: EchoEngine processes float and
+    EchoEngineDouble double, with the delay line, filters, oversampler and
+    kernels all at that precision. Parameters and control ramps are float
+    in both.
+*/
+template <typename Sample>
+class BasicEchoEngine
+{
+public:
+    static constexpr int kMaxDelayMs = 30000;
+
+    /** prepare() sizes the delay line for this much delay; longer delays
+        grow it through updateDelayLine().
+    */
+    static constexpr int kReservedDelayMs = 2000;
+
+    /** The reserved delay is sized for at least this sample rate, so
+        prepare() can switch to any rate up to it without allocating.
+    */
+    static constexpr double kPreallocatedSampleRate = ECHO_PREALLOCATE_SAMPLE_RATE;
+    static constexpr float kFeedbackMax = 0.95f;
+    static constexpr int kMaxChannels = echo::kMaxChannels;
+
+    /** Channel groups at the narrowest kernel width, two lanes. */
+    static constexpr int kMaxChannelGroups = kMaxChannels / 2;
+
+    /** While any parameter is smoothing, blocks are split into sub-blocks of
+        at most this many samples. Control values (delay time, gains, filter
+        coefficients) are computed once per sub-block and ramped linearly
+        inside it.
+    */
+    static constexpr int kControlBlockSize = 32;
+
+    /** Upper bound on how many samples are processed per internal chunk. */
+    static constexpr int kMaxChunkFrames = 256;
+
+    /** Longest run of delay-line frames gathered for one read: a chunk plus
+        as much again for a modulated delay sweeping across it.
+    */
+    static constexpr int kMaxWindowFrames = 2 * kMaxChunkFrames + 4;
+
+    /** Peak level (about -100 dB) below which input and delay line count as silent. */
+    static constexpr float kSilenceThreshold = 1.0e-5f;
+
+    /** Level the repeats decay to (-60 dB) for getTailLengthSeconds(). */
+    static constexpr float kTailThreshold = 1.0e-3f;
+
+    BasicEchoEngine() = default;
+    ~BasicEchoEngine();
+
+    /** Sets up for a sample rate and block size; call before processing and
+        whenever either changes. The delay line from an earlier prepare() is
+        reused whenever it is long enough, which it always is up to
+        kPreallocatedSampleRate, so re-preparing only resets positions.
+    */
+    void prepare(double sampleRate, int maxBlockSize, int numChannels);
+
+    /** Drops any delay line still being handed over. The delay line itself
+        is kept for the next prepare() and freed with the engine.
+    */
+    void release();
+
+    /** Grows the delay line, or converts its storage, when the parameters
+        ask for more than it has. Call regularly from one non-audio thread
+        (the plugin uses a message-thread timer); the audio thread copies the
+        current line into it over the next few blocks and then switches to
+        it. Until then delays are clamped to the current line. Returns true
+        if a new line was handed over.
+    */
+    bool updateDelayLine();
+
+    /** Frames the current delay line holds. */
+    int getDelayLineCapacity() const noexcept { return lineFrames.load(std::memory_order_relaxed); }
+
+    /** Clears all state and jumps the smoothed values to the given
+        parameters. The delay line is cleared lazily, so this takes the same
+        short time whatever its length.
+    */
+    void reset(const EchoParameters& params);
+
+    /** Processes numSamples in place.
+
+        Channels at or beyond numInputChannels are treated as copies of the
+        first input channel, so a mono input feeds both sides of the delay.
+        numSamples may exceed the maxBlockSize given to prepare(); the block
+        is processed in internal chunks either way.
+    */
+    void process(Sample* const* channels, int numChannels, int numInputChannels,
+                 int numSamples, const EchoParameters& params);
+
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    /** True if the last block took the idle path: the input was silent and
+        nothing audible was left in the delay line, so only the dry signal
+        was produced.
+    */
+    bool isAsleep() const noexcept { return asleep; }
+
+    /** How long the repeats take to decay to kTailThreshold with these
+        parameters, or infinity if the loop doesn't decay (drive can push the
+        small-signal loop gain to 1 or above).
+    */
+    static double getTailLengthSeconds(const EchoParameters& params) noexcept;
+
+    /** Turns metering on or off; safe to call from any thread. While on,
+        every block publishes a MeterSnapshot.
+    */
+    void setMeteringEnabled(bool shouldMeter) noexcept { meteringEnabled.store(shouldMeter, std::memory_order_relaxed); }
+
+    /** The newest MeterSnapshot, or nullptr if none arrived since the last
+        call. Call from one (non-audio) thread only.
+    */
+    const MeterSnapshot* pollMeters() noexcept { return meter.poll(); }
+
+    /** Latency the host should compensate for. Always 0: the only stages
+        with latency, the oversampled saturator and the diffusion network,
+        sit inside the feedback loop and are compensated there by writing
+        the feedback that many frames earlier.
+    */
+    int getLatencySamples() const noexcept { return 0; }
+
+    /** Selects the kernel instruction set; defaults to getBestKernelIsa().
+        Unsupported choices fall back to the scalar reference kernel. The
+        kernel width decides how channels are grouped, so this clears the
+        filter, oversampler and diffuser state.
+    */
+    void setKernelIsa(KernelIsa isa) noexcept;
+    const char* getKernelName() const noexcept { return kernels->name; }
+
+    static float getDivisionMultiplier(int choiceIndex) noexcept;
+    static float getSyncTimeSeconds(int choiceIndex, double bpm) noexcept;
+
+private:
+    /** Control values for one chunk. Per-tap values are stored as one array
+        per control so the mixing pass walks each of them in order.
+    */
+    struct ControlBlock
+    {
+        /** Set when a single tap passes through at unity gain, centre pan and
+            full send: its read is then both the wet signal and the feedback
+            source, and the mixing pass is skipped.
+        */
+        bool direct = false;
+
+        /** Set while the delay is modulated: modulationSamples holds each
+            channel's offset, added to the delay of every tap.
+        */
+        bool modulated = false;
+        ControlRamp modulationSamples[kMaxChannels];
+
+        ControlRamp delaySamples[kMaxTaps];
+        ControlRamp gain[kMaxTaps];         // channels past the panned pair
+        ControlRamp leftGain[kMaxTaps];
+        ControlRamp rightGain[kMaxTaps];
+        ControlRamp feedbackSend[kMaxTaps];
+
+        ControlRamp feedbackGain;
+        ControlRamp dryGain;
+        ControlRamp wetGain;
+        ControlRamp outputGain;
+
+        /** Allpass coefficient of the diffusion network, held for the chunk. */
+        float diffusion = 0.0f;
+    };
+
+    float delayMsToSamples(float delayMs) const noexcept;
+    bool isSmoothing(bool synced) const noexcept;
+    void setTapTargets(const EchoParameters& params, bool synced) noexcept;
+    void requestDelayLine(const EchoParameters& params, bool synced) noexcept;
+    void adoptPendingLine(int numFrames) noexcept;
+    void updateMaximumDelay() noexcept;
+    int getChunkLength(int remaining, int maxFrames, bool synced) const noexcept;
+    void setOversampling(Oversampling mode) noexcept;
+    void setDiffusion(const DiffusionParameters& settings) noexcept;
+    void setDiffusionSize(float size) noexcept;
+    void updateFeedbackLatency() noexcept;
+    void setInterpolation(Interpolation mode) noexcept;
+    void updateMinimumDelay() noexcept;
+    ControlBlock advanceControls(int numFrames, bool synced) noexcept;
+    void readTaps(int numFrames, const ControlBlock& controls) noexcept;
+    void mixTaps(int numFrames, const ControlBlock& controls) noexcept;
+    void readDelayedChunk(int numFrames, ControlRamp delaySamples, const ControlBlock& controls,
+                          Sample* destination, Sample* state) noexcept;
+
+    template <Interpolation mode>
+    void readDelayedChunk(int numFrames, ControlRamp delaySamples, Sample* destination, Sample* state) noexcept;
+
+    template <Interpolation mode>
+    void readModulatedChunk(int numFrames, ControlRamp delaySamples, const ControlRamp* offsets,
+                            Sample* destination, Sample* state) noexcept;
+
+    template <Interpolation mode>
+    void readConstantDelay(int numFrames, float delaySamples, Sample* destination, Sample* state) noexcept;
+    void processFeedbackChunk(Sample* const* channels, int numChannels, int numInputChannels,
+                              int startSample, int numFrames, const ControlBlock& controls,
+                              const PingPongRouting* routing, DriveStage driveStage, float driveGain) noexcept;
+    void routeFeedback(const Sample** sources, const PingPongRouting& routing, int numChannels,
+                       int numFrames) noexcept;
+    void resetChannelGroups() noexcept;
+
+    void setFilterCutoffs(float lowCutHz, float highCutHz) noexcept;
+    void setFilterSlope(FilterSlope slope) noexcept;
+
+    void setModulationTargets(const ModulationParameters& settings, double hostBpm) noexcept;
+    bool isModulating() const noexcept;
+    int getModulationChunkFrames() const noexcept;
+    void advanceModulation(int numFrames, ControlRamp* ramps) noexcept;
+
+    bool canSleep(Sample* const* channels, int numInputChannels, int numSamples) const noexcept;
+    void processAsleep(Sample* const* channels, int numChannels, int numInputChannels, int numSamples) noexcept;
+    void trackWrittenLevel(int numFrames) noexcept;
+    void commitWrittenFrames(int numFrames) noexcept;
+
+    double sampleRate = 44100.0;
+    int numDelayChannels = 0;
+
+    // Channels in the delay line and scratch buffers: numDelayChannels
+    // rounded up to even, so every kernel group is a pair or a full group.
+    int numLineChannels = 2;
+
+    DelayLine<Sample> delayLine;
+    int maxDelayFrames = 1;
+    float maxDelaySamples = 1.0f;
+    float minDelaySamples = 1.0f;
+
+    // How far back reads may reach: the longest delay asked for since
+    // prepare() (at least kReservedDelayMs), within the line's capacity.
+    // Once that many frames are silent, nothing audible can be read.
+    int readableFrames = 1;
+
+    oversampling::OversamplerLanes<Sample> oversamplers[kMaxChannelGroups];
+    Oversampling activeOversampling = Oversampling::off;
+    int feedbackLatency = 0;
+
+    Interpolation activeInterpolation = Interpolation::linear;
+    Sample allpassState[kMaxTaps][kMaxChannels] = {};
+
+    // Wet signal for the current chunk, one run of kMaxChunkFrames per
+    // channel: the summed taps, or the single tap's read on the direct path.
+    std::vector<Sample> delayedScratch;
+
+    // Summed feedback sends for the current chunk, laid out like delayedScratch.
+    std::vector<Sample> feedbackScratch;
+
+    // Feedback mixed by a ping-pong matrix, laid out like delayedScratch.
+    std::vector<Sample> routedScratch;
+
+    // Each tap's read for the current chunk, numLineChannels runs per tap.
+    std::vector<Sample> tapScratch;
+
+    // Frames the kernel writes, starting feedbackLatency frames before the
+    // write head at writeOffset frames in. Frames before the feedback head
+    // are final and copied into the delay line after each chunk; the newest
+    // feedbackLatency frames still get feedback added by later chunks, so
+    // they stay here, moving up by a chunk each time.
+    std::vector<Sample> writeScratch;
+    int writeOffset = 0;
+
+    Sample* getFeedbackFrames() noexcept { return writeScratch.data() + writeOffset * numLineChannels; }
+
+    // Delay-line frames gathered for a constant-delay or modulated read.
+    std::vector<Sample> windowScratch;
+
+    // Delay-line hand-over: the audio thread publishes what it needs in
+    // requestedFrames/requestedStorage and what it has in lineFrames/
+    // lineStorage/lineChannels; updateDelayLine() posts a new line in
+    // pendingLine, the audio thread copies the old line into it over the
+    // next few blocks, then swaps and returns the old storage in
+    // retiredLine for freeing.
+    std::atomic<int> requestedFrames { 0 };
+    std::atomic<int> requestedStorage { 0 };
+    std::atomic<int> lineFrames { 0 };
+    std::atomic<int> lineStorage { 0 };
+    std::atomic<int> lineChannels { 0 };
+    std::atomic<DelayLine<Sample>*> pendingLine { nullptr };
+    std::atomic<DelayLine<Sample>*> retiredLine { nullptr };
+
+    // The pending line whose copy the audio thread has begun.
+    DelayLine<Sample>* copyingLine = nullptr;
+
+    // Output for channels the caller didn't pass in, and input for the
+    // padding channel.
+    std::vector<Sample> discardScratch;
+    std::vector<Sample> silenceScratch;
+
+    const EchoKernels<Sample>* kernels = &getKernels<Sample>(getBestKernelIsa());
+
+    // Taps below runningTaps are read: the active ones plus any still
+    // fading out after numTaps was lowered.
+    int runningTaps = 1;
+    float tapSyncTimeMs[kMaxTaps] = {};
+    LinearSmoother tapTimeSmoothed[kMaxTaps];
+    LinearSmoother tapGainSmoothed[kMaxTaps];
+    LinearSmoother tapPanSmoothed[kMaxTaps];
+    LinearSmoother tapSendSmoothed[kMaxTaps];
+
+    LinearSmoother feedbackSmoothed;
+    LinearSmoother mixSmoothed;
+    LinearSmoother outputSmoothed;
+
+    LinearSmoother lowCutSmoothed;
+    LinearSmoother highCutSmoothed;
+    float currentLowCutHz = -1.0f;
+    float currentHighCutHz = -1.0f;
+    FilterSlope activeFilterSlope = FilterSlope::db12;
+
+    // Depth is smoothed in ms. modulationOffsets holds each channel's offset,
+    // in samples, at the last frame processed: the next chunk's ramps start
+    // from there.
+    ModulationLfo modulationLfo;
+    double modulationCyclesPerFrame = 0.0;
+    LinearSmoother modulationDepthSmoothed;
+    LinearSmoother modulationDriftSmoothed;
+    LinearSmoother modulationSpreadSmoothed;
+    float modulationOffsets[kMaxChannels] = {};
+
+    // Frames since anything at or above kSilenceThreshold was written to the
+    // delay line, saturating at its capacity: once the whole ring is quiet,
+    // no delay setting can read anything audible from it.
+    int framesSinceAudibleWrite = 0;
+    bool asleep = false;
+
+    std::atomic<bool> meteringEnabled { false };
+    EchoMeter meter;
+
+    // One bank per channel group, all with the same coefficients.
+    SvfLanes<Sample> lowCutFilters[kMaxChannelGroups];
+    SvfLanes<Sample> highCutFilters[kMaxChannelGroups];
+
+    // Diffusion runs from the moment its amount leaves 0 until it has faded
+    // back there, and its latency counts in feedbackLatency for as long. The
+    // arena holds each group's rings in one region of
+    // diffusion::getRegionFrames() frames, the groups back to back.
+    std::vector<DiffuserFrame<Sample>> diffusionArena;
+    DiffuserLanes<Sample> diffusers[kMaxChannelGroups];
+    LinearSmoother diffusionSmoothed;
+    LinearSmoother diffusionSizeSmoothed;
+    bool diffusionActive = false;
+};
+
+// Both are instantiated in EchoEngine.cpp.
+extern template class BasicEchoEngine<float>;
+extern template class BasicEchoEngine<double>;
+
+using EchoEngine = BasicEchoEngine<float>;
+using EchoEngineDouble = BasicEchoEngine<double>;
+}
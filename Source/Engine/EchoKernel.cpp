@@ -0,0 +1,99 @@
+#include "EchoKernel.h"
+
+#include <initializer_list>
+
+#include "EchoKernelImpl.h"
+#include "Simd.h"
+
+#if ECHO_SIMD_X86 && defined(_MSC_VER) && ! defined(__clang__)
+ #include <intrin.h>
+#endif
+
+namespace echo
+{
+namespace
+{
+#if ECHO_SIMD_X86
+bool cpuSupportsAvx2() noexcept
+{
+   #if defined(_MSC_VER) && ! defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (! osxsave || ! fma || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+   #else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+   #endif
+}
+#endif
+}
+
+template <typename Sample>
+const EchoKernels<Sample>& getScalarKernels() noexcept
+{
+    return kernel::makeKernels<simd::ScalarLanes<Sample, 2>>("scalar");
+}
+
+bool isKernelIsaSupported(KernelIsa isa) noexcept
+{
+    switch (isa)
+    {
+        case KernelIsa::scalar: return true;
+       #if ECHO_SIMD_X86
+        case KernelIsa::sse2: return true;
+        case KernelIsa::avx2:
+        {
+            static const bool supported = cpuSupportsAvx2();
+            return supported;
+        }
+       #endif
+       #if ECHO_SIMD_NEON
+        case KernelIsa::neon: return true;
+       #endif
+        default: return false;
+    }
+}
+
+KernelIsa getBestKernelIsa() noexcept
+{
+    for (auto isa : { KernelIsa::avx2, KernelIsa::sse2, KernelIsa::neon })
+        if (isKernelIsaSupported(isa))
+            return isa;
+
+    return KernelIsa::scalar;
+}
+
+template <typename Sample>
+const EchoKernels<Sample>& getKernels(KernelIsa isa) noexcept
+{
+    if (! isKernelIsaSupported(isa))
+        return getScalarKernels<Sample>();
+
+    switch (isa)
+    {
+       #if ECHO_SIMD_X86
+        case KernelIsa::sse2: return getSse2Kernels<Sample>();
+        case KernelIsa::avx2: return getAvx2Kernels<Sample>();
+       #endif
+       #if ECHO_SIMD_NEON
+        case KernelIsa::neon: return getNeonKernels<Sample>();
+       #endif
+        default: return getScalarKernels<Sample>();
+    }
+}
+
+template const EchoKernels<float>& getScalarKernels<float>() noexcept;
+template const EchoKernels<double>& getScalarKernels<double>() noexcept;
+template const EchoKernels<float>& getKernels<float>(KernelIsa) noexcept;
+template const EchoKernels<double>& getKernels<double>(KernelIsa) noexcept;
+}
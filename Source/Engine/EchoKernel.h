@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Oversampling.h"
+
+namespace echo
+{
+template <typename Sample>
+struct SvfLanes;
+
+template <typename Sample>
+struct DiffuserLanes;
+
+namespace oversampling
+{
+template <typename Sample>
+struct OversamplerLanes;
+}
+
+/** Which saturator the feedback kernel runs; see DriveQuality. */
+enum class DriveStage
+{
+    bypassed,
+    exact,
+    rational,
+    table
+};
+
+constexpr int kNumDriveStages = 4;
+
+/** A control value ramped linearly across a chunk: frame i uses first + i * step. */
+struct ControlRamp
+{
+    float first;
+    float step;
+
+    float at(int frame) const noexcept { return first + static_cast<float>(frame) * step; }
+};
+
+/** Most channels one kernel call runs, one per lane. */
+constexpr int kMaxKernelLanes = 4;
+
+/** Everything the feedback/mix kernel needs for one chunk of one group of
+    channels.
+
+    The engine splits its channels into groups of EchoKernels::numLanes and
+    runs the kernel once per group, each channel in its own lane. Channel
+    pointers are already resolved (ping-pong routing, mono input, padding
+    lanes), so the kernel only streams lanes through the loop. Audio is
+    float or double; control values stay float either way.
+*/
+template <typename Sample>
+struct FeedbackKernelArgs
+{
+    const Sample* feedbackSources[kMaxKernelLanes];
+    const Sample* delayed[kMaxKernelLanes];
+    const Sample* inputs[kMaxKernelLanes];
+    Sample* outputs[kMaxKernelLanes];
+
+    /** The group's first channel in interleaved delay-line frames,
+        frameStride samples apart and contiguous for numFrames. The input is
+        written to writeFrames. The feedback is added to feedbackFrames,
+        which sit the oversampler's and the diffuser's latency earlier so
+        the repeats stay on time; with neither, both point at the same
+        frames.
+    */
+    Sample* writeFrames;
+    Sample* feedbackFrames;
+    int frameStride;
+
+    /** Control values, ramped across the chunk by the engine's sub-block scheduler. */
+    ControlRamp feedbackGain;
+    ControlRamp dryGain;
+    ControlRamp wetGain;
+    ControlRamp outputGain;
+
+    float driveGain;
+    int numFrames;
+
+    /** saturation::getTanhTable(), for DriveStage::table. */
+    const float* tanhTable;
+
+    oversampling::OversamplerLanes<Sample>* oversampler;
+
+    SvfLanes<Sample>* lowCut;
+    SvfLanes<Sample>* highCut;
+
+    /** The allpass coefficient, constant across the chunk, and the group's
+        network; used by the kDiffusion variants only.
+    */
+    float diffusion;
+    DiffuserLanes<Sample>* diffuser;
+};
+
+enum class KernelIsa
+{
+    scalar,
+    sse2,
+    avx2,
+    neon
+};
+
+/** Flags selecting a compile-time specialised kernel variant; see EchoKernels. */
+enum KernelVariantFlags
+{
+    /** At least one gain ramps across the chunk; otherwise all are constant. */
+    kRampingGains = 1,
+
+    /** All inputs point at the same channel, which is read once per frame. */
+    kMonoInput = 2,
+
+    /** Every lane carries a channel; otherwise only lanes 0 and 1 do. */
+    kAllLanes = 4,
+
+    /** LowCut and HighCut run both filter stages (24 dB/oct). */
+    kSteepFilters = 8,
+
+    /** The filtered feedback runs through the allpass diffusion network. */
+    kDiffusion = 16
+};
+
+constexpr int kNumKernelVariants = 32;
+
+template <typename Sample>
+using FeedbackKernel = void (*)(const FeedbackKernelArgs<Sample>&) noexcept;
+
+template <typename Sample>
+struct EchoKernels
+{
+    /** Indexed by [Oversampling][DriveStage][KernelVariantFlags]. */
+    FeedbackKernel<Sample> processFeedback[kNumOversamplingModes][kNumDriveStages][kNumKernelVariants];
+    const char* name;
+
+    /** Channels one call runs: 2 or 4. */
+    int numLanes;
+};
+
+/** Kernels for the given instruction set, or the scalar ones if it isn't
+    compiled in. The getters below are defined for float and double: float
+    kernels run four channels per call on every SIMD instruction set, double
+    kernels two on SSE2 and NEON and four on AVX2, and the scalar kernels
+    two.
+*/
+template <typename Sample>
+const EchoKernels<Sample>& getKernels(KernelIsa isa) noexcept;
+
+/** True if kernels for this instruction set are compiled in and the CPU runs them. */
+bool isKernelIsaSupported(KernelIsa isa) noexcept;
+
+/** The fastest instruction set this CPU supports. */
+KernelIsa getBestKernelIsa() noexcept;
+
+template <typename Sample> const EchoKernels<Sample>& getScalarKernels() noexcept;
+template <typename Sample> const EchoKernels<Sample>& getSse2Kernels() noexcept;
+template <typename Sample> const EchoKernels<Sample>& getAvx2Kernels() noexcept;
+template <typename Sample> const EchoKernels<Sample>& getNeonKernels() noexcept;
+}
@@ -0,0 +1,25 @@
+// Built with AVX2/FMA code generation (see CMakeLists.txt); only reached
+// after getKernels() has checked the CPU.
+
+#include "SimdAvx2.h"
+
+#if ECHO_SIMD_X86
+ #include <type_traits>
+
+ #include "EchoKernelImpl.h"
+
+namespace echo
+{
+template <typename Sample>
+const EchoKernels<Sample>& getAvx2Kernels() noexcept
+{
+    if constexpr (std::is_same_v<Sample, double>)
+        return kernel::makeKernels<simd::Avx2Doubles>("avx2");
+    else
+        return kernel::makeKernels<simd::Avx2Floats>("avx2");
+}
+
+template const EchoKernels<float>& getAvx2Kernels<float>() noexcept;
+template const EchoKernels<double>& getAvx2Kernels<double>() noexcept;
+}
+#endif
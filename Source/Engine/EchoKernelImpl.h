@@ -0,0 +1,422 @@
+#pragma once
+
+// Kernel templates, instantiated once per instruction set by the
+// EchoKernel*.cpp files. Translation units built with different ISA flags
+// must not share inline code, so everything here is a template over the
+// lane type and only calls lane-type members or C library functions.
+
+#include <math.h>
+#include <type_traits>
+#include <utility>
+
+#include "Diffusion.h"
+#include "EchoKernel.h"
+#include "Oversampling.h"
+#include "Saturation.h"
+#include "StateVariableFilter.h"
+
+namespace echo
+{
+namespace kernel
+{
+/** One SvfLanes bank in registers: numStages cascaded TPT state-variable
+    filters, taking the high-pass or the low-pass output of each.
+*/
+template <typename Vec, bool highPass, int numStages>
+struct SvfKernel
+{
+    using Sample = typename Vec::Sample;
+
+    Vec a1[numStages], a2[numStages], a3[numStages], k[numStages];
+    Vec ic1[numStages], ic2[numStages];
+
+    explicit SvfKernel(const SvfLanes<Sample>& filter) noexcept
+    {
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            a1[stage] = Vec::broadcast(filter.stages[stage].a1);
+            a2[stage] = Vec::broadcast(filter.stages[stage].a2);
+            a3[stage] = Vec::broadcast(filter.stages[stage].a3);
+            k[stage] = Vec::broadcast(filter.stages[stage].k);
+            ic1[stage] = Vec::load(filter.ic1[stage]);
+            ic2[stage] = Vec::load(filter.ic2[stage]);
+        }
+    }
+
+    Vec process(Vec x) noexcept
+    {
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            const Vec v3 = x - ic2[stage];
+            const Vec v1 = Vec::mulAdd(a1[stage], ic1[stage], a2[stage] * v3);
+            const Vec v2 = Vec::mulAdd(a2[stage], ic1[stage], Vec::mulAdd(a3[stage], v3, ic2[stage]));
+            ic1[stage] = v1 + v1 - ic1[stage];
+            ic2[stage] = v2 + v2 - ic2[stage];
+
+            if constexpr (highPass)
+                x = x - Vec::mulAdd(k[stage], v1, v2);
+            else
+                x = v2;
+        }
+
+        return x;
+    }
+
+    void saveState(SvfLanes<Sample>& filter) const noexcept
+    {
+        for (int stage = 0; stage < numStages; ++stage)
+        {
+            ic1[stage].store(filter.ic1[stage]);
+            ic2[stage].store(filter.ic2[stage]);
+        }
+    }
+};
+
+/** A DiffuserLanes network in lane form: a plain delay, then the
+    Schroeder allpasses in series, each frame of a ring one aligned row of
+    lanes.
+*/
+template <typename Vec>
+struct DiffuserKernel
+{
+    using Sample = typename Vec::Sample;
+
+    DiffuserKernel(DiffuserLanes<Sample>& stateToUse, float coefficient) noexcept
+        : state(stateToUse)
+        , g(Vec::broadcast(static_cast<Sample>(coefficient)))
+        , position(stateToUse.position)
+    {
+    }
+
+    ~DiffuserKernel() noexcept { state.position = position & state.positionMask; }
+
+    Vec process(Vec x) noexcept
+    {
+        // Written before it is read, so a delay of 0 passes straight through.
+        x.store(row(0, position));
+        x = Vec::load(row(0, position - state.delays[0]));
+
+        for (int ring = 1; ring < diffusion::kNumRings; ++ring)
+        {
+            const Vec delayed = Vec::load(row(ring, position - state.delays[ring]));
+            const Vec w = x - g * delayed;
+            w.store(row(ring, position));
+            x = Vec::mulAdd(g, w, delayed);
+        }
+
+        ++position;
+        return x;
+    }
+
+private:
+    Sample* row(int ring, int index) const noexcept
+    {
+        return state.frames[state.offsets[ring] + (index & state.masks[ring])].lanes;
+    }
+
+    DiffuserLanes<Sample>& state;
+    const Vec g;
+    int position;
+};
+
+template <typename Vec>
+struct Saturator
+{
+    using Sample = typename Vec::Sample;
+
+    static Sample lookup(Sample x, const float* table) noexcept
+    {
+        constexpr Sample range = saturation::kTanhTableRange;
+        constexpr Sample scale = saturation::kTanhTableSize / (2 * range);
+
+        const Sample clamped = x < -range ? -range : (x > range ? range : x);
+        const Sample position = (clamped + range) * scale;
+        const int index = static_cast<int>(position);
+        const Sample frac = position - static_cast<Sample>(index);
+        return table[index] + frac * (table[index + 1] - table[index]);
+    }
+
+    static Sample exactTanh(Sample x) noexcept
+    {
+        if constexpr (std::is_same_v<Sample, double>)
+            return tanh(x);
+        else
+            return tanhf(x);
+    }
+
+    /** Applies a scalar function to every lane, or to lanes 0 and 1 only. */
+    template <bool allLanes, typename Function>
+    static Vec forEachLane(Vec x, Function function) noexcept
+    {
+        if constexpr (allLanes)
+        {
+            alignas(sizeof(Vec)) Sample values[Vec::kNumLanes];
+            x.store(values);
+
+            for (auto& value : values)
+                value = function(value);
+
+            return Vec::load(values);
+        }
+        else
+        {
+            return Vec::fromPair(function(x.lane0()), function(x.lane1()));
+        }
+    }
+
+    template <DriveStage stage, bool allLanes>
+    static Vec process(Vec x, const float* table) noexcept
+    {
+        if constexpr (stage == DriveStage::exact)
+            return forEachLane<allLanes>(x, [](Sample value) { return exactTanh(value); });
+        else if constexpr (stage == DriveStage::rational)
+            return saturation::rationalTanh(x);
+        else if constexpr (stage == DriveStage::table)
+            return forEachLane<allLanes>(x, [table](Sample value) { return lookup(value, table); });
+        else
+            return x;
+    }
+};
+
+/** Moves one frame of a group between lanes and memory: all lanes, or
+    lanes 0 and 1 only.
+*/
+template <typename Vec, bool allLanes>
+struct LaneIo
+{
+    using Sample = typename Vec::Sample;
+
+    /** Lane i from channels[i][index]. */
+    static Vec loadChannels(const Sample* const* channels, int index) noexcept
+    {
+        if constexpr (allLanes)
+            return Vec::gather(channels, index);
+        else
+            return Vec::fromPair(channels[0][index], channels[1][index]);
+    }
+
+    static void storeChannels(Vec x, Sample* const* channels, int index) noexcept
+    {
+        if constexpr (allLanes)
+        {
+            x.scatter(channels, index);
+        }
+        else
+        {
+            channels[0][index] = x.lane0();
+            channels[1][index] = x.lane1();
+        }
+    }
+
+    /** Lane i from frame[i], where the group's channels sit side by side. */
+    static Vec loadFrame(const Sample* frame) noexcept
+    {
+        if constexpr (allLanes)
+            return Vec::loadUnaligned(frame);
+        else
+            return Vec::fromPair(frame[0], frame[1]);
+    }
+
+    static void storeFrame(Vec x, Sample* frame) noexcept
+    {
+        if constexpr (allLanes)
+            x.storeUnaligned(frame);
+        else
+            x.storePair(frame);
+    }
+};
+
+/** A ControlRamp in lane form. Constant ramps are broadcast once per chunk. */
+template <typename Vec, bool ramping>
+struct RampKernel
+{
+    float first;
+    float step;
+    Vec constant;
+
+    explicit RampKernel(ControlRamp rampToUse) noexcept
+        : first(rampToUse.first)
+        , step(rampToUse.step)
+        , constant(Vec::broadcast(rampToUse.first))
+    {
+    }
+
+    /** ControlRamp::at is not a template, so the sum is repeated here. */
+    Vec at(int frame) const noexcept
+    {
+        if constexpr (ramping)
+            return Vec::broadcast(first + static_cast<float>(frame) * step);
+        else
+            return constant;
+    }
+};
+
+/** The saturator, run at 1x, 2x or 4x through the half-band stages. */
+template <typename Vec, DriveStage driveStage, Oversampling mode, bool allLanes>
+struct OversampledSaturator
+{
+    using Sample = typename Vec::Sample;
+
+    explicit OversampledSaturator(const FeedbackKernelArgs<Sample>& args) noexcept
+        : state(*args.oversampler)
+        , stage1Taps(oversampling::getStage1Taps<Sample>())
+        , stage2Taps(oversampling::getStage2Taps<Sample>())
+        , table(args.tanhTable)
+        , pending(Vec::load(state.stage2Pending))
+    {
+    }
+
+    ~OversampledSaturator() noexcept { pending.store(state.stage2Pending); }
+
+    Vec process(Vec x) noexcept
+    {
+        if constexpr (mode == Oversampling::off)
+        {
+            return saturate(x);
+        }
+        else
+        {
+            Vec first, second;
+            oversampling::interpolate(state.stage1, stage1Taps, x, first, second);
+
+            if constexpr (mode == Oversampling::x2)
+            {
+                first = saturate(first);
+                second = saturate(second);
+            }
+            else
+            {
+                const Vec firstDown = processStage2(first);
+                const Vec secondDown = processStage2(second);
+
+                // Delay the 2x stream by one sample to keep the latency whole.
+                first = pending;
+                second = firstDown;
+                pending = secondDown;
+            }
+
+            return oversampling::decimate(state.stage1, stage1Taps, first, second);
+        }
+    }
+
+private:
+    Vec saturate(Vec x) const noexcept
+    {
+        return Saturator<Vec>::template process<driveStage, allLanes>(x, table);
+    }
+
+    Vec processStage2(Vec x) noexcept
+    {
+        Vec first, second;
+        oversampling::interpolate(state.stage2, stage2Taps, x, first, second);
+        return oversampling::decimate(state.stage2, stage2Taps, saturate(first), saturate(second));
+    }
+
+    oversampling::OversamplerLanes<Sample>& state;
+    const oversampling::HalfBandTaps<Sample, oversampling::kStage1SideTaps>& stage1Taps;
+    const oversampling::HalfBandTaps<Sample, oversampling::kStage2SideTaps>& stage2Taps;
+    const float* table;
+    Vec pending;
+};
+
+template <typename Vec, Oversampling oversamplingMode, DriveStage driveStage, int variant>
+void processFeedback(const FeedbackKernelArgs<typename Vec::Sample>& args) noexcept
+{
+    constexpr bool ramping = (variant & kRampingGains) != 0;
+    constexpr bool monoInput = (variant & kMonoInput) != 0;
+    constexpr bool allLanes = (variant & kAllLanes) != 0;
+    constexpr int filterStages = (variant & kSteepFilters) != 0 ? 2 : 1;
+    constexpr bool diffused = (variant & kDiffusion) != 0;
+
+    // Either stage delays the feedback, which is then written that much earlier.
+    constexpr bool delayedFeedback = oversamplingMode != Oversampling::off || diffused;
+    using Io = LaneIo<Vec, allLanes>;
+
+    SvfKernel<Vec, true, filterStages> lowCut(*args.lowCut);
+    SvfKernel<Vec, false, filterStages> highCut(*args.highCut);
+    DiffuserKernel<Vec> diffuser(*args.diffuser, args.diffusion);
+    const Vec driveGain = Vec::broadcast(args.driveGain);
+    OversampledSaturator<Vec, driveStage, oversamplingMode, allLanes> saturator(args);
+    const int stride = args.frameStride;
+
+    const RampKernel<Vec, ramping> feedbackGain(args.feedbackGain);
+    const RampKernel<Vec, ramping> dryGain(args.dryGain);
+    const RampKernel<Vec, ramping> wetGain(args.wetGain);
+    const RampKernel<Vec, ramping> outputGain(args.outputGain);
+
+    for (int i = 0; i < args.numFrames; ++i)
+    {
+        Vec filtered = Io::loadChannels(args.feedbackSources, i);
+        filtered = lowCut.process(filtered);
+        filtered = highCut.process(filtered);
+
+        if constexpr (diffused)
+            filtered = diffuser.process(filtered);
+
+        if constexpr (driveStage != DriveStage::bypassed)
+            filtered = saturator.process(filtered * driveGain);
+
+        const Vec input = monoInput ? Vec::broadcast(args.inputs[0][i]) : Io::loadChannels(args.inputs, i);
+        const Vec delayed = Io::loadChannels(args.delayed, i);
+
+        if constexpr (! delayedFeedback)
+        {
+            Io::storeFrame(Vec::mulAdd(filtered, feedbackGain.at(i), input), args.writeFrames + i * stride);
+        }
+        else
+        {
+            auto* feedbackFrame = args.feedbackFrames + i * stride;
+            Io::storeFrame(input, args.writeFrames + i * stride);
+            Io::storeFrame(Vec::mulAdd(filtered, feedbackGain.at(i), Io::loadFrame(feedbackFrame)), feedbackFrame);
+        }
+
+        const Vec mixed = Vec::mulAdd(input, dryGain.at(i), delayed * wetGain.at(i));
+        Io::storeChannels(mixed * outputGain.at(i), args.outputs, i);
+    }
+
+    lowCut.saveState(*args.lowCut);
+    highCut.saveState(*args.highCut);
+}
+
+template <typename Vec, Oversampling oversamplingMode, DriveStage driveStage, int... variants>
+void fillVariants(FeedbackKernel<typename Vec::Sample> (&table)[kNumKernelVariants],
+                  std::integer_sequence<int, variants...>) noexcept
+{
+    // With two lanes, all of them is the pair.
+    constexpr int laneMask = Vec::kNumLanes > 2 ? ~0 : ~kAllLanes;
+    ((table[variants] = &processFeedback<Vec, oversamplingMode, driveStage, variants & laneMask>), ...);
+}
+
+template <typename Vec, Oversampling oversamplingMode, DriveStage driveStage>
+void fillVariants(FeedbackKernel<typename Vec::Sample> (&table)[kNumKernelVariants]) noexcept
+{
+    fillVariants<Vec, oversamplingMode, driveStage>(table, std::make_integer_sequence<int, kNumKernelVariants>());
+}
+
+template <typename Vec, Oversampling oversamplingMode>
+void fillDriveStages(FeedbackKernel<typename Vec::Sample> (&stages)[kNumDriveStages][kNumKernelVariants]) noexcept
+{
+    // A bypassed saturator is linear, so it never needs oversampling.
+    fillVariants<Vec, Oversampling::off, DriveStage::bypassed>(stages[static_cast<int>(DriveStage::bypassed)]);
+    fillVariants<Vec, oversamplingMode, DriveStage::exact>(stages[static_cast<int>(DriveStage::exact)]);
+    fillVariants<Vec, oversamplingMode, DriveStage::rational>(stages[static_cast<int>(DriveStage::rational)]);
+    fillVariants<Vec, oversamplingMode, DriveStage::table>(stages[static_cast<int>(DriveStage::table)]);
+}
+
+template <typename Vec>
+const EchoKernels<typename Vec::Sample>& makeKernels(const char* name) noexcept
+{
+    static const EchoKernels<typename Vec::Sample> kernels = [name]
+    {
+        EchoKernels<typename Vec::Sample> table {};
+        fillDriveStages<Vec, Oversampling::off>(table.processFeedback[static_cast<int>(Oversampling::off)]);
+        fillDriveStages<Vec, Oversampling::x2>(table.processFeedback[static_cast<int>(Oversampling::x2)]);
+        fillDriveStages<Vec, Oversampling::x4>(table.processFeedback[static_cast<int>(Oversampling::x4)]);
+        table.name = name;
+        table.numLanes = Vec::kNumLanes < kMaxKernelLanes ? Vec::kNumLanes : kMaxKernelLanes;
+        return table;
+    }();
+    return kernels;
+}
+}
+}
@@ -0,0 +1,29 @@
+#include "SimdNeon.h"
+
+#if ECHO_SIMD_NEON
+ #include <type_traits>
+
+ #include "EchoKernelImpl.h"
+
+namespace echo
+{
+#if ECHO_SIMD_NEON_DOUBLES
+using NeonDoubleLanes = simd::NeonDoubles;
+#else
+// 32-bit ARM has no double-precision NEON, so doubles run the portable lanes.
+using NeonDoubleLanes = simd::ScalarLanes<double, 2>;
+#endif
+
+template <typename Sample>
+const EchoKernels<Sample>& getNeonKernels() noexcept
+{
+    if constexpr (std::is_same_v<Sample, double>)
+        return kernel::makeKernels<NeonDoubleLanes>("neon");
+    else
+        return kernel::makeKernels<simd::NeonFloats>("neon");
+}
+
+template const EchoKernels<float>& getNeonKernels<float>() noexcept;
+template const EchoKernels<double>& getNeonKernels<double>() noexcept;
+}
+#endif
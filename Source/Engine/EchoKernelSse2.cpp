@@ -0,0 +1,22 @@
+#include "SimdSse2.h"
+
+#if ECHO_SIMD_X86
+ #include <type_traits>
+
+ #include "EchoKernelImpl.h"
+
+namespace echo
+{
+template <typename Sample>
+const EchoKernels<Sample>& getSse2Kernels() noexcept
+{
+    if constexpr (std::is_same_v<Sample, double>)
+        return kernel::makeKernels<simd::Sse2Doubles>("sse2");
+    else
+        return kernel::makeKernels<simd::Sse2Floats>("sse2");
+}
+
+template const EchoKernels<float>& getSse2Kernels<float>() noexcept;
+template const EchoKernels<double>& getSse2Kernels<double>() noexcept;
+}
+#endif
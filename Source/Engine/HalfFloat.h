@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace echo
+{
+namespace half
+{
+/** IEEE 754 binary32 to binary16, rounding to nearest even. Values beyond
+    the half range become infinity; NaN stays NaN.
+
+    Works on the bit patterns with one float addition for the subnormal
+    range, so it is exact with flush-to-zero enabled as well.
+*/
+inline uint16_t fromFloat(float value) noexcept
+{
+    constexpr uint32_t infinityBits = 255u << 23;
+    constexpr uint32_t halfOverflowBits = (127u + 16u) << 23;
+    constexpr uint32_t smallestNormalBits = 113u << 23;
+    constexpr uint32_t subnormalMagicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t result;
+
+    if (bits >= halfOverflowBits)
+    {
+        result = bits > infinityBits ? 0x7e00u : 0x7c00u;
+    }
+    else if (bits < smallestNormalBits)
+    {
+        // Adding the magic value lines the ten mantissa bits up at the bottom
+        // of the float, with the FPU doing the rounding.
+        float magic;
+        std::memcpy(&magic, &subnormalMagicBits, sizeof(magic));
+
+        float aligned;
+        std::memcpy(&aligned, &bits, sizeof(aligned));
+        aligned += magic;
+
+        std::memcpy(&bits, &aligned, sizeof(bits));
+        result = bits - subnormalMagicBits;
+    }
+    else
+    {
+        const uint32_t mantissaOdd = (bits >> 13) & 1u;
+        bits += ((15u - 127u) << 23) + 0xfffu + mantissaOdd;
+        result = bits >> 13;
+    }
+
+    return static_cast<uint16_t>(result | (sign >> 16));
+}
+
+/** IEEE 754 binary16 to binary32; exact for every value. */
+inline float toFloat(uint16_t value) noexcept
+{
+    constexpr uint32_t shiftedExponent = 0x7c00u << 13;
+    constexpr uint32_t renormaliseBits = 113u << 23;
+
+    uint32_t bits = (static_cast<uint32_t>(value) & 0x7fffu) << 13;
+    const uint32_t exponent = bits & shiftedExponent;
+    bits += (127u - 15u) << 23;
+
+    if (exponent == shiftedExponent)
+    {
+        bits += (128u - 16u) << 23;
+    }
+    else if (exponent == 0)
+    {
+        bits += 1u << 23;
+
+        float renormalise;
+        std::memcpy(&renormalise, &renormaliseBits, sizeof(renormalise));
+
+        float subnormal;
+        std::memcpy(&subnormal, &bits, sizeof(subnormal));
+        subnormal -= renormalise;
+        std::memcpy(&bits, &subnormal, sizeof(bits));
+    }
+
+    bits |= (static_cast<uint32_t>(value) & 0x8000u) << 16;
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/** Converts float or double samples; doubles are rounded to float first. */
+template <typename Sample>
+inline void encode(const Sample* source, uint16_t* destination, int numValues) noexcept
+{
+    for (int i = 0; i < numValues; ++i)
+        destination[i] = fromFloat(static_cast<float>(source[i]));
+}
+
+template <typename Sample>
+inline void decode(const uint16_t* source, Sample* destination, int numValues) noexcept
+{
+    for (int i = 0; i < numValues; ++i)
+        destination[i] = static_cast<Sample>(toFloat(source[i]));
+}
+}
+}
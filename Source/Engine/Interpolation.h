@@ -0,0 +1,77 @@
+#pragma once
+
+namespace echo
+{
+/** How the delay line is read between samples. */
+enum class Interpolation
+{
+    linear,     // two-point, cheapest; dulls the top end a little per repeat
+    hermite,    // 4-point, 3rd-order Catmull-Rom spline
+    lagrange,   // 4-point, 3rd-order Lagrange polynomial
+    allpass     // first-order Thiran allpass: flat magnitude, recursive
+};
+
+constexpr int kNumInterpolations = 4;
+
+namespace interpolation
+{
+/** Frames a mode reads beyond the newer sample of the linear pair, which
+    raises the shortest delay the engine allows by the same amount.
+*/
+constexpr int getLookahead(Interpolation mode) noexcept
+{
+    return mode == Interpolation::linear ? 0 : 1;
+}
+
+/** FIR weights for the four points around a fractional delay of t (0..1)
+    between p1 and p2, ordered newest (p0) to oldest (p3).
+*/
+template <Interpolation mode, typename T>
+inline void getWeights(T t, T (&weights)[4]) noexcept
+{
+    static_assert(mode == Interpolation::hermite || mode == Interpolation::lagrange, "FIR modes only");
+
+    constexpr T half = T(1) / T(2);
+
+    if constexpr (mode == Interpolation::hermite)
+    {
+        const T t2 = t * t;
+        const T t3 = t2 * t;
+        weights[0] = -half * t + t2 - half * t3;
+        weights[1] = T(1) - T(2.5) * t2 + T(1.5) * t3;
+        weights[2] = half * t + T(2) * t2 - T(1.5) * t3;
+        weights[3] = -half * t2 + half * t3;
+    }
+    else
+    {
+        // Points sit at -1, 0, 1 and 2 relative to p1.
+        constexpr T sixth = T(1) / T(6);
+        const T tPlus1 = t + T(1);
+        const T tMinus1 = t - T(1);
+        const T tMinus2 = t - T(2);
+        weights[0] = -t * tMinus1 * tMinus2 * sixth;
+        weights[1] = tPlus1 * tMinus1 * tMinus2 * half;
+        weights[2] = -tPlus1 * t * tMinus2 * half;
+        weights[3] = tPlus1 * t * tMinus1 * sixth;
+    }
+}
+
+/** Splits a delay into the allpass tap and coefficient. The fractional part
+    is kept within [0.5, 1.5), where the first-order Thiran allpass has the
+    flattest group delay, by moving the tap one frame closer when needed.
+*/
+inline void getAllpassTap(float delaySamples, int& tap, float& coefficient) noexcept
+{
+    tap = static_cast<int>(delaySamples);
+    float fraction = delaySamples - static_cast<float>(tap);
+
+    if (fraction < 0.5f)
+    {
+        --tap;
+        fraction += 1.0f;
+    }
+
+    coefficient = (1.0f - fraction) / (1.0f + fraction);
+}
+}
+}
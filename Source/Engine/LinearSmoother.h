@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cmath>
+
+namespace echo
+{
+/** Linear parameter ramp with the same stepping behaviour as
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear>.
+*/
+class LinearSmoother
+{
+public:
+    void reset(double sampleRate, double rampLengthSeconds) noexcept
+    {
+        stepsToTarget = static_cast<int>(std::floor(rampLengthSeconds * sampleRate));
+        setCurrentAndTargetValue(target);
+    }
+
+    void setCurrentAndTargetValue(float newValue) noexcept
+    {
+        target = current = newValue;
+        countdown = 0;
+    }
+
+    void setTargetValue(float newValue) noexcept
+    {
+        if (newValue == target)
+            return;
+
+        if (stepsToTarget <= 0)
+        {
+            setCurrentAndTargetValue(newValue);
+            return;
+        }
+
+        target = newValue;
+        countdown = stepsToTarget;
+        step = (target - current) / static_cast<float>(countdown);
+    }
+
+    float getNextValue() noexcept
+    {
+        if (! isSmoothing())
+            return target;
+
+        --countdown;
+
+        if (isSmoothing())
+            current += step;
+        else
+            current = target;
+
+        return current;
+    }
+
+    /** Advances the ramp by numSamples and returns the value reached. */
+    float skip(int numSamples) noexcept
+    {
+        if (numSamples >= countdown)
+        {
+            setCurrentAndTargetValue(target);
+            return target;
+        }
+
+        current += step * static_cast<float>(numSamples);
+        countdown -= numSamples;
+        return current;
+    }
+
+    bool isSmoothing() const noexcept { return countdown > 0; }
+    float getCurrentValue() const noexcept { return current; }
+    float getTargetValue() const noexcept { return target; }
+
+private:
+    float current = 0.0f;
+    float target = 0.0f;
+    float step = 0.0f;
+    int countdown = 0;
+    int stepsToTarget = 0;
+};
+}
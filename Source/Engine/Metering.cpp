@@ -0,0 +1,161 @@
+#include "Metering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace echo
+{
+namespace
+{
+int getFramesPerColumn(int maxDelayFrames) noexcept
+{
+    return std::max(1, (maxDelayFrames + MeterSnapshot::kOverviewColumns - 1) / MeterSnapshot::kOverviewColumns);
+}
+
+template <typename Sample>
+void measure(const Sample* samples, int numSamples, float& peak, float& rms) noexcept
+{
+    Sample maxLevel = 0;
+    Sample sumOfSquares = 0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        maxLevel = std::max(maxLevel, std::abs(samples[i]));
+        sumOfSquares += samples[i] * samples[i];
+    }
+
+    peak = static_cast<float>(maxLevel);
+    rms = numSamples > 0 ? static_cast<float>(std::sqrt(sumOfSquares / static_cast<Sample>(numSamples))) : 0.0f;
+}
+}
+
+void EchoMeter::prepare(int maxDelayFrames) noexcept
+{
+    framesPerColumn = getFramesPerColumn(maxDelayFrames);
+
+    std::fill(std::begin(columnMin), std::end(columnMin), 0.0f);
+    std::fill(std::begin(columnMax), std::end(columnMax), 0.0f);
+    nextColumn = 0;
+    currentMin = currentMax = 0.0f;
+    currentFrames = 0;
+}
+
+void EchoMeter::setMaximumDelay(int maxDelayFrames) noexcept
+{
+    constexpr int numColumns = MeterSnapshot::kOverviewColumns;
+    const int newFramesPerColumn = getFramesPerColumn(maxDelayFrames);
+
+    if (newFramesPerColumn == framesPerColumn)
+        return;
+
+    if (newFramesPerColumn < framesPerColumn)
+    {
+        prepare(maxDelayFrames);
+        return;
+    }
+
+    // Each finished column goes into the wider column covering its age,
+    // newest first, so the history stays in place at the new scale.
+    float mergedMin[numColumns] = {};
+    float mergedMax[numColumns] = {};
+
+    for (int age = 0; age < numColumns; ++age)
+    {
+        const int column = (nextColumn - 1 - age + numColumns) % numColumns;
+        const int merged = numColumns - 1 - static_cast<int>(static_cast<int64_t>(age) * framesPerColumn / newFramesPerColumn);
+        mergedMin[merged] = std::min(mergedMin[merged], columnMin[column]);
+        mergedMax[merged] = std::max(mergedMax[merged], columnMax[column]);
+    }
+
+    std::copy(std::begin(mergedMin), std::end(mergedMin), std::begin(columnMin));
+    std::copy(std::begin(mergedMax), std::end(mergedMax), std::begin(columnMax));
+    nextColumn = 0;
+    framesPerColumn = newFramesPerColumn;
+}
+
+template <typename Sample>
+void EchoMeter::beginBlock(const Sample* const* inputs, int numInputChannels, int numSamples) noexcept
+{
+    for (int channel = 0; channel < MeterSnapshot::kNumChannels; ++channel)
+        measure(inputs[std::min(channel, numInputChannels - 1)], numSamples, inputPeak[channel], inputRms[channel]);
+
+    loopPeak = 0.0f;
+}
+
+template <typename Sample>
+void EchoMeter::addWrittenFrames(const Sample* frames, int numFrames, int numChannels) noexcept
+{
+    while (numFrames > 0)
+    {
+        const int count = std::min(numFrames, framesPerColumn - currentFrames);
+        float low = currentMin;
+        float high = currentMax;
+
+        for (int i = 0; i < count * numChannels; ++i)
+        {
+            low = std::min(low, static_cast<float>(frames[i]));
+            high = std::max(high, static_cast<float>(frames[i]));
+        }
+
+        currentMin = low;
+        currentMax = high;
+        loopPeak = std::max({ loopPeak, -low, high });
+        currentFrames += count;
+        frames += count * numChannels;
+        numFrames -= count;
+
+        if (currentFrames == framesPerColumn)
+        {
+            columnMin[nextColumn] = currentMin;
+            columnMax[nextColumn] = currentMax;
+            nextColumn = (nextColumn + 1) % MeterSnapshot::kOverviewColumns;
+            currentMin = currentMax = 0.0f;
+            currentFrames = 0;
+        }
+    }
+}
+
+template <typename Sample>
+void EchoMeter::endBlock(const Sample* const* outputs, int numChannels, int numSamples,
+                         float feedbackGain, float delaySamples) noexcept
+{
+    MeterSnapshot& snapshot = snapshots.getWriteBuffer();
+    snapshot.blockCounter = ++blockCounter;
+
+    for (int channel = 0; channel < MeterSnapshot::kNumChannels; ++channel)
+    {
+        snapshot.inputPeak[channel] = inputPeak[channel];
+        snapshot.inputRms[channel] = inputRms[channel];
+        measure(outputs[std::min(channel, numChannels - 1)], numSamples,
+                snapshot.outputPeak[channel], snapshot.outputRms[channel]);
+    }
+
+    snapshot.loopPeak = loopPeak;
+    snapshot.feedbackGain = feedbackGain;
+    snapshot.delaySamples = delaySamples;
+    snapshot.framesPerColumn = framesPerColumn;
+
+    // Unroll the ring so the snapshot reads oldest to newest.
+    const int olderColumns = MeterSnapshot::kOverviewColumns - nextColumn;
+    std::memcpy(snapshot.overviewMin, columnMin + nextColumn, sizeof(float) * static_cast<size_t>(olderColumns));
+    std::memcpy(snapshot.overviewMin + olderColumns, columnMin, sizeof(float) * static_cast<size_t>(nextColumn));
+    std::memcpy(snapshot.overviewMax, columnMax + nextColumn, sizeof(float) * static_cast<size_t>(olderColumns));
+    std::memcpy(snapshot.overviewMax + olderColumns, columnMax, sizeof(float) * static_cast<size_t>(nextColumn));
+
+    snapshots.publish();
+}
+
+const MeterSnapshot* EchoMeter::poll() noexcept
+{
+    return snapshots.update() ? &snapshots.getReadBuffer() : nullptr;
+}
+
+template void EchoMeter::beginBlock(const float* const*, int, int) noexcept;
+template void EchoMeter::beginBlock(const double* const*, int, int) noexcept;
+template void EchoMeter::addWrittenFrames(const float*, int, int) noexcept;
+template void EchoMeter::addWrittenFrames(const double*, int, int) noexcept;
+template void EchoMeter::endBlock(const float* const*, int, int, float, float) noexcept;
+template void EchoMeter::endBlock(const double* const*, int, int, float, float) noexcept;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+
+#include "TripleBuffer.h"
+
+namespace echo
+{
+/** What the engine did during one block, for display. */
+struct MeterSnapshot
+{
+    /** Levels are metered for the first two channels only, the front
+        left/right pair of any layout; the overview covers all of them.
+    */
+    static constexpr int kNumChannels = 2;
+
+    /** Overview columns; together they span the longest delay. */
+    static constexpr int kOverviewColumns = 256;
+
+    uint64_t blockCounter = 0;
+
+    float inputPeak[kNumChannels] = {};
+    float inputRms[kNumChannels] = {};
+    float outputPeak[kNumChannels] = {};
+    float outputRms[kNumChannels] = {};
+
+    /** Peak written into the delay line this block: input plus feedback. It
+        climbs block after block when the loop runs away.
+    */
+    float loopPeak = 0.0f;
+
+    float feedbackGain = 0.0f;
+    float delaySamples = 0.0f;
+
+    /** Frames of audio summarised by each overview column. */
+    int framesPerColumn = 1;
+
+    /** Min/max of everything written to the delay line, oldest column
+        first; the newest column ends at the write head.
+    */
+    float overviewMin[kOverviewColumns] = {};
+    float overviewMax[kOverviewColumns] = {};
+};
+
+/** Collects levels and a decimated overview of the delay line on the audio
+    thread and publishes them as MeterSnapshots through a TripleBuffer.
+    Nothing here locks or allocates after prepare().
+*/
+class EchoMeter
+{
+public:
+    /** Sizes the overview columns so all of them together cover maxDelayFrames. */
+    void prepare(int maxDelayFrames) noexcept;
+
+    /** Widens the overview columns for a longer delay line, merging the
+        history into them rather than clearing it.
+    */
+    void setMaximumDelay(int maxDelayFrames) noexcept;
+
+    /** The audio functions take float or double samples. */
+    template <typename Sample>
+    void beginBlock(const Sample* const* inputs, int numInputChannels, int numSamples) noexcept;
+
+    /** Adds frames just written to the delay line, numChannels interleaved. */
+    template <typename Sample>
+    void addWrittenFrames(const Sample* frames, int numFrames, int numChannels) noexcept;
+
+    template <typename Sample>
+    void endBlock(const Sample* const* outputs, int numChannels, int numSamples,
+                  float feedbackGain, float delaySamples) noexcept;
+
+    /** Consumer side: the newest snapshot if one arrived since the last call,
+        otherwise nullptr. The pointer stays valid until the next call.
+    */
+    const MeterSnapshot* poll() noexcept;
+
+private:
+    TripleBuffer<MeterSnapshot> snapshots;
+
+    uint64_t blockCounter = 0;
+    float inputPeak[MeterSnapshot::kNumChannels] = {};
+    float inputRms[MeterSnapshot::kNumChannels] = {};
+    float loopPeak = 0.0f;
+
+    // Finished columns as a ring, plus the one being filled.
+    int framesPerColumn = 1;
+    float columnMin[MeterSnapshot::kOverviewColumns] = {};
+    float columnMax[MeterSnapshot::kOverviewColumns] = {};
+    int nextColumn = 0;
+    float currentMin = 0.0f;
+    float currentMax = 0.0f;
+    int currentFrames = 0;
+};
+}
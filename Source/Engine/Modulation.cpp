@@ -0,0 +1,28 @@
+#include "Modulation.h"
+
+namespace echo
+{
+namespace modulation
+{
+const float* getSineTable() noexcept
+{
+    struct Table
+    {
+        Table() noexcept
+        {
+            constexpr double twoPi = 6.28318530717958647693;
+
+            for (int i = 0; i < kSineTableSize; ++i)
+                values[i] = static_cast<float>(std::sin(twoPi * i / kSineTableSize));
+
+            values[kSineTableSize] = values[0];
+        }
+
+        float values[kSineTableSize + 1];
+    };
+
+    static const Table table;
+    return table.values;
+}
+}
+}
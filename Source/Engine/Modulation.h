@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace echo
+{
+/** Settings for the delay-time modulation: tape-style wow and drift at
+    slow rates and small depths, chorus at faster ones.
+*/
+struct ModulationParameters
+{
+    float depthMs = 0.0f;       // peak deviation of every delay time; 0 turns modulation off
+    float rateHz = 0.5f;
+    bool syncEnabled = false;   // one LFO cycle per syncDivision of the host tempo, when there is one
+    int syncDivision = 0;
+    float drift = 0.0f;         // 0..1, crossfades from the sine to smoothed random drift
+    float spread = 0.5f;        // 0..1, channel phase offsets; 1 spaces the channels evenly round the cycle
+};
+
+namespace modulation
+{
+constexpr float kMaxDepthMs = 20.0f;
+constexpr float kMinRateHz = 0.01f;
+constexpr float kMaxRateHz = 20.0f;
+
+constexpr int kSineTableSize = 512;
+
+/** kSineTableSize + 1 points of one sine cycle, the last repeating the
+    first so interpolation at the end of the cycle stays in bounds.
+*/
+const float* getSineTable() noexcept;
+
+/** sin(2 pi phase) for phase in [0, 1), interpolated linearly in the
+    table; max error 1.9e-5.
+*/
+inline float sine(const float* table, double phase) noexcept
+{
+    const double position = phase * kSineTableSize;
+    const int index = static_cast<int>(position);
+    const float fraction = static_cast<float>(position - index);
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
+/** A random value in [-1, 1] for each whole cycle, from an integer hash so
+    any channel can look up any cycle without keeping state.
+*/
+inline float randomPoint(uint32_t cycle) noexcept
+{
+    cycle ^= cycle >> 16;
+    cycle *= 0x7feb352dU;
+    cycle ^= cycle >> 15;
+    cycle *= 0x846ca68bU;
+    cycle ^= cycle >> 16;
+    return static_cast<float>(cycle >> 8) * (2.0f / 16777215.0f) - 1.0f;
+}
+
+/** Smoothed random drift in [-1, 1]: a new random value every cycle,
+    joined by smoothstep curves so the delay never changes direction
+    abruptly.
+*/
+inline float drift(double phase) noexcept
+{
+    const double cycle = std::floor(phase);
+    const float t = static_cast<float>(phase - cycle);
+    const auto index = static_cast<uint32_t>(static_cast<int64_t>(cycle));
+    const float from = randomPoint(index);
+    const float to = randomPoint(index + 1);
+    return from + (to - from) * t * t * (3.0f - 2.0f * t);
+}
+}
+
+/** The modulation LFOs of all channels: one running phase, with each
+    channel reading the sine and drift sources a fixed fraction of a cycle
+    further on. The engine evaluates it once per sub-block and ramps the
+    delay linearly in between, so no channel runs a per-sample sin().
+*/
+class ModulationLfo
+{
+public:
+    void reset() noexcept { phase = 0.0; }
+
+    /** Moves the phase on by numFrames at the given rate. */
+    void advance(double cyclesPerFrame, int numFrames) noexcept
+    {
+        phase += cyclesPerFrame * numFrames;
+    }
+
+    /** One channel's value in [-1, 1] at the current phase. */
+    float getValue(double phaseOffset, float driftAmount) const noexcept
+    {
+        const double channelPhase = phase + phaseOffset;
+        const float wave = modulation::sine(sineTable, channelPhase - std::floor(channelPhase));
+
+        if (driftAmount <= 0.0f)
+            return wave;
+
+        return wave + driftAmount * (modulation::drift(channelPhase) - wave);
+    }
+
+private:
+    double phase = 0.0;
+    const float* sineTable = modulation::getSineTable();
+};
+}
@@ -0,0 +1,82 @@
+#include "Oversampling.h"
+
+#include <cmath>
+
+namespace echo
+{
+namespace oversampling
+{
+namespace
+{
+double besselI0(double x) noexcept
+{
+    double sum = 1.0;
+    double term = 1.0;
+
+    for (int k = 1; k < 32; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+/** Kaiser-windowed sinc half-band design, normalised to unity DC gain. */
+template <typename Sample, int SideTaps>
+HalfBandTaps<Sample, SideTaps> design(double beta) noexcept
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr int numTaps = 2 * SideTaps - 1;
+    constexpr int centre = (numTaps - 1) / 2;
+
+    double side[SideTaps];
+    double sum = 0.0;
+
+    for (int i = 0; i < SideTaps; ++i)
+    {
+        // Even-indexed taps are the non-zero off-centre ones.
+        const int offset = 2 * i - centre;
+        const double ratio = (2.0 * (2 * i)) / (numTaps - 1) - 1.0;
+        const double window = besselI0(beta * std::sqrt(1.0 - ratio * ratio)) / besselI0(beta);
+        side[i] = std::sin(pi * offset / 2.0) / (pi * offset) * window;
+        sum += side[i];
+    }
+
+    HalfBandTaps<Sample, SideTaps> result;
+
+    for (int i = 0; i < SideTaps; ++i)
+    {
+        const Sample tap = static_cast<Sample>(side[i] * 0.5 / sum);
+
+        for (int lane = 0; lane < kNumLanes; ++lane)
+        {
+            result.taps[i][lane] = tap;
+            result.interpolatorTaps[i][lane] = 2 * tap;
+        }
+    }
+
+    return result;
+}
+}
+
+template <typename Sample>
+const HalfBandTaps<Sample, kStage1SideTaps>& getStage1Taps() noexcept
+{
+    static const auto taps = design<Sample, kStage1SideTaps>(8.0);
+    return taps;
+}
+
+template <typename Sample>
+const HalfBandTaps<Sample, kStage2SideTaps>& getStage2Taps() noexcept
+{
+    static const auto taps = design<Sample, kStage2SideTaps>(6.0);
+    return taps;
+}
+
+template const HalfBandTaps<float, kStage1SideTaps>& getStage1Taps<float>() noexcept;
+template const HalfBandTaps<double, kStage1SideTaps>& getStage1Taps<double>() noexcept;
+template const HalfBandTaps<float, kStage2SideTaps>& getStage2Taps<float>() noexcept;
+template const HalfBandTaps<double, kStage2SideTaps>& getStage2Taps<double>() noexcept;
+}
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+
+namespace echo
+{
+/** Oversampling applied around the drive saturator only. */
+enum class Oversampling
+{
+    off,
+    x2,
+    x4
+};
+
+constexpr int kNumOversamplingModes = 3;
+
+namespace oversampling
+{
+/** Polyphase half-band FIR stages.
+
+    A half-band filter with 2 * SideTaps - 1 taps has a centre tap of 0.5
+    and every other tap zero, so one polyphase branch is SideTaps
+    multiplies and the other a pure delay. Stage 1 runs between the base
+    rate and 2x, stage 2 between 2x and 4x, where the spectrum above the
+    base-rate band is already attenuated and a shorter filter suffices.
+*/
+constexpr int kStage1SideTaps = 16;
+constexpr int kStage2SideTaps = 8;
+constexpr int kNumLanes = 4;
+
+/** Round-trip group delay of the up/down chain in base-rate samples.
+
+    Stage 1 contributes kStage1SideTaps - 1. Stage 2 contributes half of
+    kStage2SideTaps - 1; it is padded by one 2x-rate sample so the total
+    stays a whole number of base-rate samples.
+*/
+constexpr int getLatencySamples(Oversampling mode) noexcept
+{
+    return mode == Oversampling::x2 ? kStage1SideTaps - 1
+         : mode == Oversampling::x4 ? kStage1SideTaps - 1 + kStage2SideTaps / 2
+         : 0;
+}
+
+/** Rows of kNumLanes samples are aligned for whole-register loads. */
+template <typename Sample>
+constexpr size_t kLaneAlignment = kNumLanes * sizeof(Sample);
+
+/** The non-zero off-centre taps of a half-band stage, pre-broadcast to lanes. */
+template <typename Sample, int SideTaps>
+struct HalfBandTaps
+{
+    alignas(kLaneAlignment<Sample>) Sample taps[SideTaps][kNumLanes];
+    alignas(kLaneAlignment<Sample>) Sample interpolatorTaps[SideTaps][kNumLanes];  // taps * 2 for unity gain
+};
+
+/** Defined for float and double. */
+template <typename Sample>
+const HalfBandTaps<Sample, kStage1SideTaps>& getStage1Taps() noexcept;
+
+template <typename Sample>
+const HalfBandTaps<Sample, kStage2SideTaps>& getStage2Taps() noexcept;
+
+/** Per-lane history of one half-band stage.
+
+    Each ring holds SideTaps entries and is stored twice so the newest
+    SideTaps values are always contiguous from position.
+*/
+template <typename Sample, int SideTaps>
+struct HalfBandLanes
+{
+    alignas(kLaneAlignment<Sample>) Sample input[2 * SideTaps][kNumLanes];
+    alignas(kLaneAlignment<Sample>) Sample evenOutput[2 * SideTaps][kNumLanes];
+    alignas(kLaneAlignment<Sample>) Sample oddOutput[2 * SideTaps][kNumLanes];
+    int position = 0;
+
+    void reset() noexcept
+    {
+        for (int i = 0; i < 2 * SideTaps; ++i)
+            for (int lane = 0; lane < kNumLanes; ++lane)
+                input[i][lane] = evenOutput[i][lane] = oddOutput[i][lane] = 0;
+
+        position = 0;
+    }
+};
+
+/** State for the whole oversampled saturator. */
+template <typename Sample>
+struct OversamplerLanes
+{
+    HalfBandLanes<Sample, kStage1SideTaps> stage1;
+    HalfBandLanes<Sample, kStage2SideTaps> stage2;
+
+    // One 2x-rate sample of padding on the 4x path.
+    alignas(kLaneAlignment<Sample>) Sample stage2Pending[kNumLanes];
+
+    void reset() noexcept
+    {
+        stage1.reset();
+        stage2.reset();
+
+        for (auto& value : stage2Pending)
+            value = 0;
+    }
+};
+
+template <int SideTaps, typename Sample, typename Vec>
+void pushHistory(Sample (*ring)[kNumLanes], int position, Vec value) noexcept
+{
+    value.store(ring[position]);
+    value.store(ring[position + SideTaps]);
+}
+
+/** Upsamples one sample into two; the first output is the earlier one. */
+template <typename Vec, typename Sample, int SideTaps>
+void interpolate(HalfBandLanes<Sample, SideTaps>& state, const HalfBandTaps<Sample, SideTaps>& taps,
+                 Vec input, Vec& first, Vec& second) noexcept
+{
+    pushHistory<SideTaps>(state.input, state.position, input);
+    const Sample (*history)[kNumLanes] = state.input + state.position;
+
+    Vec sum = Vec::load(history[0]) * Vec::load(taps.interpolatorTaps[0]);
+
+    for (int i = 1; i < SideTaps; ++i)
+        sum = Vec::mulAdd(Vec::load(history[i]), Vec::load(taps.interpolatorTaps[i]), sum);
+
+    first = sum;
+    second = Vec::load(history[SideTaps / 2 - 1]);
+}
+
+/** Filters two samples down to one. Call after interpolate() for the same stage. */
+template <typename Vec, typename Sample, int SideTaps>
+Vec decimate(HalfBandLanes<Sample, SideTaps>& state, const HalfBandTaps<Sample, SideTaps>& taps,
+             Vec first, Vec second) noexcept
+{
+    pushHistory<SideTaps>(state.evenOutput, state.position, first);
+    pushHistory<SideTaps>(state.oddOutput, state.position, second);
+
+    const Sample (*even)[kNumLanes] = state.evenOutput + state.position;
+    const Sample (*odd)[kNumLanes] = state.oddOutput + state.position;
+
+    Vec sum = Vec::load(odd[SideTaps / 2]) * Vec::broadcast(0.5f);
+
+    for (int i = 0; i < SideTaps; ++i)
+        sum = Vec::mulAdd(Vec::load(even[i]), Vec::load(taps.taps[i]), sum);
+
+    state.position = (state.position == 0 ? SideTaps : state.position) - 1;
+    return sum;
+}
+}
+}
@@ -0,0 +1,282 @@
+#include "RealtimeMonitor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#if ECHO_RT_GUARD
+ #include <cstdlib>
+ #include <new>
+#endif
+
+#if ECHO_RT_GUARD_WRAP_LOCKS
+ #include <pthread.h>
+ #include <semaphore.h>
+#endif
+
+namespace echo
+{
+namespace
+{
+// Per-thread counters, so the totals a BlockScope sees come from its own
+// thread only. Plain integers: operator new must not allocate to count.
+thread_local int audioThreadDepth = 0;
+thread_local uint64_t threadBlockingCalls = 0;
+
+#if ECHO_RT_GUARD
+thread_local uint64_t threadAllocations = 0;
+thread_local uint64_t threadDeallocations = 0;
+
+int64_t getNanoseconds() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void* allocate(std::size_t size) noexcept
+{
+    if (audioThreadDepth > 0)
+        ++threadAllocations;
+
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void deallocate(void* pointer) noexcept
+{
+    if (pointer != nullptr && audioThreadDepth > 0)
+        ++threadDeallocations;
+
+    std::free(pointer);
+}
+#endif
+}
+
+double RealtimeMonitor::Snapshot::getPercentileLoad(double percentile) const noexcept
+{
+    if (blocks == 0)
+        return 0.0;
+
+    const double rank = std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(blocks);
+    uint64_t count = 0;
+
+    for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+    {
+        count += buckets[bucket];
+
+        if (static_cast<double>(count) >= rank)
+            return bucket == kNumBuckets - 1 ? worstLoad : (bucket + 1) * kBucketWidth;
+    }
+
+    return worstLoad;
+}
+
+#if ECHO_RT_GUARD
+RealtimeMonitor::BlockScope::BlockScope(RealtimeMonitor& monitorToUse, int numSamples, double sampleRate) noexcept
+    : monitor(monitorToUse)
+    , budgetSeconds(sampleRate > 0.0 ? numSamples / sampleRate : 0.0)
+    , startNanoseconds(getNanoseconds())
+    , startAllocations(threadAllocations)
+    , startDeallocations(threadDeallocations)
+    , startBlockingCalls(threadBlockingCalls)
+    , outermost(audioThreadDepth == 0)
+{
+    ++audioThreadDepth;
+}
+
+RealtimeMonitor::BlockScope::~BlockScope() noexcept
+{
+    --audioThreadDepth;
+
+    if (! outermost || budgetSeconds <= 0.0)
+        return;
+
+    const double elapsedSeconds = static_cast<double>(getNanoseconds() - startNanoseconds) * 1.0e-9;
+    monitor.recordBlock(elapsedSeconds / budgetSeconds,
+                        threadAllocations - startAllocations,
+                        threadDeallocations - startDeallocations,
+                        threadBlockingCalls - startBlockingCalls);
+}
+#else
+RealtimeMonitor::BlockScope::BlockScope(RealtimeMonitor&, int, double) noexcept {}
+RealtimeMonitor::BlockScope::~BlockScope() noexcept {}
+#endif
+
+void RealtimeMonitor::recordBlock(double load, uint64_t newAllocations, uint64_t newDeallocations,
+                                  uint64_t newBlockingCalls) noexcept
+{
+    // Single writer, so plain load/store is enough for the non-integer totals.
+    blocks.fetch_add(1, std::memory_order_relaxed);
+    allocations.fetch_add(newAllocations, std::memory_order_relaxed);
+    deallocations.fetch_add(newDeallocations, std::memory_order_relaxed);
+    blockingCalls.fetch_add(newBlockingCalls, std::memory_order_relaxed);
+
+    if (load > 1.0)
+        overruns.fetch_add(1, std::memory_order_relaxed);
+
+    if (load > worstLoad.load(std::memory_order_relaxed))
+        worstLoad.store(load, std::memory_order_relaxed);
+
+    totalLoad.store(totalLoad.load(std::memory_order_relaxed) + load, std::memory_order_relaxed);
+
+    const int bucket = std::min(kNumBuckets - 1, static_cast<int>(load / kBucketWidth));
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+RealtimeMonitor::Snapshot RealtimeMonitor::getSnapshot() const noexcept
+{
+    Snapshot snapshot;
+    snapshot.blocks = blocks.load(std::memory_order_relaxed);
+    snapshot.allocations = allocations.load(std::memory_order_relaxed);
+    snapshot.deallocations = deallocations.load(std::memory_order_relaxed);
+    snapshot.blockingCalls = blockingCalls.load(std::memory_order_relaxed);
+    snapshot.overruns = overruns.load(std::memory_order_relaxed);
+    snapshot.worstLoad = worstLoad.load(std::memory_order_relaxed);
+    snapshot.meanLoad = snapshot.blocks > 0 ? totalLoad.load(std::memory_order_relaxed) / static_cast<double>(snapshot.blocks)
+                                            : 0.0;
+
+    for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+        snapshot.buckets[bucket] = buckets[bucket].load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+void RealtimeMonitor::resetStatistics() noexcept
+{
+    blocks.store(0, std::memory_order_relaxed);
+    allocations.store(0, std::memory_order_relaxed);
+    deallocations.store(0, std::memory_order_relaxed);
+    blockingCalls.store(0, std::memory_order_relaxed);
+    overruns.store(0, std::memory_order_relaxed);
+    worstLoad.store(0.0, std::memory_order_relaxed);
+    totalLoad.store(0.0, std::memory_order_relaxed);
+
+    for (auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+std::string RealtimeMonitor::formatReport() const
+{
+    const Snapshot snapshot = getSnapshot();
+
+    char text[512];
+    std::snprintf(text, sizeof(text),
+                  "{ \"enabled\": %s, \"blocks\": %llu, \"allocations\": %llu, \"deallocations\": %llu, "
+                  "\"blocking_calls\": %llu, \"overruns\": %llu, \"mean_load\": %.4f, \"p50_load\": %.2f, "
+                  "\"p99_load\": %.2f, \"worst_load\": %.4f, \"bucket_width\": %.2f, \"histogram\": [",
+                  kEnabled ? "true" : "false",
+                  static_cast<unsigned long long>(snapshot.blocks),
+                  static_cast<unsigned long long>(snapshot.allocations),
+                  static_cast<unsigned long long>(snapshot.deallocations),
+                  static_cast<unsigned long long>(snapshot.blockingCalls),
+                  static_cast<unsigned long long>(snapshot.overruns),
+                  snapshot.meanLoad, snapshot.getPercentileLoad(50.0), snapshot.getPercentileLoad(99.0),
+                  snapshot.worstLoad, kBucketWidth);
+
+    std::string report = text;
+
+    for (int bucket = 0; bucket < kNumBuckets; ++bucket)
+    {
+        std::snprintf(text, sizeof(text), bucket > 0 ? ", %llu" : "%llu",
+                      static_cast<unsigned long long>(snapshot.buckets[bucket]));
+        report += text;
+    }
+
+    report += "] }";
+    return report;
+}
+
+void RealtimeMonitor::noteBlockingCall() noexcept
+{
+    if (audioThreadDepth > 0)
+        ++threadBlockingCalls;
+}
+
+bool RealtimeMonitor::isAudioThread() noexcept
+{
+    return audioThreadDepth > 0;
+}
+}
+
+#if ECHO_RT_GUARD
+// Replacements for the global allocation functions; the aligned overloads
+// keep their default implementation.
+void* operator new(std::size_t size)
+{
+    if (void* pointer = echo::allocate(size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return echo::allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return echo::allocate(size);
+}
+
+void operator delete(void* pointer) noexcept { echo::deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { echo::deallocate(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { echo::deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { echo::deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { echo::deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { echo::deallocate(pointer); }
+#endif
+
+#if ECHO_RT_GUARD_WRAP_LOCKS
+// Linked with -Wl,--wrap=<function> (see CMakeLists.txt), so every call to
+// these from code linked into the same binary lands here first.
+extern "C"
+{
+int __real_pthread_mutex_lock(pthread_mutex_t*);
+int __real_pthread_cond_wait(pthread_cond_t*, pthread_mutex_t*);
+int __real_pthread_cond_timedwait(pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+int __real_pthread_rwlock_rdlock(pthread_rwlock_t*);
+int __real_pthread_rwlock_wrlock(pthread_rwlock_t*);
+int __real_sem_wait(sem_t*);
+
+int __wrap_pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    echo::RealtimeMonitor::noteBlockingCall();
+    return __real_pthread_mutex_lock(mutex);
+}
+
+int __wrap_pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+{
+    echo::RealtimeMonitor::noteBlockingCall();
+    return __real_pthread_cond_wait(condition, mutex);
+}
+
+int __wrap_pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+{
+    echo::RealtimeMonitor::noteBlockingCall();
+    return __real_pthread_cond_timedwait(condition, mutex, time);
+}
+
+int __wrap_pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+{
+    echo::RealtimeMonitor::noteBlockingCall();
+    return __real_pthread_rwlock_rdlock(lock);
+}
+
+int __wrap_pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+{
+    echo::RealtimeMonitor::noteBlockingCall();
+    return __real_pthread_rwlock_wrlock(lock);
+}
+
+int __wrap_sem_wait(sem_t* semaphore)
+{
+    echo::RealtimeMonitor::noteBlockingCall();
+    return __real_sem_wait(semaphore);
+}
+}
+#endif
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Build with -DECHO_RT_GUARD=ON (CMake) to enable the instrumentation. When
+// off, BlockScope compiles to nothing and the statistics stay at zero.
+#ifndef ECHO_RT_GUARD
+ #define ECHO_RT_GUARD 0
+#endif
+
+namespace echo
+{
+/** Real-time safety statistics for an audio callback.
+
+    A BlockScope placed around each callback marks the thread as the audio
+    thread while it runs, counts heap allocations and blocking calls made
+    meanwhile, and records the block's wall time against its real-time
+    budget (numSamples / sampleRate) in a lock-free histogram.
+
+    The audio thread is the only writer; any thread may read a Snapshot.
+    Allocations are counted through replaced global operator new/delete.
+    Blocking calls are counted on Linux, where the pthread lock and wait
+    functions are wrapped at link time, and wherever noteBlockingCall() is
+    called explicitly.
+*/
+class RealtimeMonitor
+{
+public:
+    static constexpr bool kEnabled = ECHO_RT_GUARD != 0;
+
+    /** Histogram buckets cover 0-200% of the budget in 5% steps; the last
+        one collects everything from 200% up.
+    */
+    static constexpr int kNumBuckets = 41;
+    static constexpr double kBucketWidth = 0.05;
+
+    struct Snapshot
+    {
+        uint64_t blocks = 0;
+        uint64_t allocations = 0;
+        uint64_t deallocations = 0;
+        uint64_t blockingCalls = 0;
+
+        /** Blocks that took longer than their budget. */
+        uint64_t overruns = 0;
+
+        /** Block time as a fraction of the budget. */
+        double worstLoad = 0.0;
+        double meanLoad = 0.0;
+
+        uint64_t buckets[kNumBuckets] = {};
+
+        /** Upper edge of the bucket holding the given percentile (0-100). */
+        double getPercentileLoad(double percentile) const noexcept;
+    };
+
+    /** Guards one audio callback; see the class description. Nests safely. */
+    class BlockScope
+    {
+    public:
+        BlockScope(RealtimeMonitor& monitor, int numSamples, double sampleRate) noexcept;
+        ~BlockScope() noexcept;
+
+        BlockScope(const BlockScope&) = delete;
+        BlockScope& operator=(const BlockScope&) = delete;
+
+    private:
+#if ECHO_RT_GUARD
+        RealtimeMonitor& monitor;
+        double budgetSeconds;
+        int64_t startNanoseconds;
+        uint64_t startAllocations;
+        uint64_t startDeallocations;
+        uint64_t startBlockingCalls;
+        bool outermost;
+#endif
+    };
+
+    Snapshot getSnapshot() const noexcept;
+
+    /** Clears the statistics. Counts from a block in flight may be lost. */
+    void resetStatistics() noexcept;
+
+    /** The snapshot as a JSON object, for headless dumps. Allocates, so
+        don't call it from the audio thread.
+    */
+    std::string formatReport() const;
+
+    /** Counts a call that may block if made on a guarded thread. */
+    static void noteBlockingCall() noexcept;
+
+    /** True while the calling thread is inside a BlockScope. */
+    static bool isAudioThread() noexcept;
+
+private:
+    void recordBlock(double load, uint64_t allocations, uint64_t deallocations, uint64_t blockingCalls) noexcept;
+
+    std::atomic<uint64_t> blocks { 0 };
+    std::atomic<uint64_t> allocations { 0 };
+    std::atomic<uint64_t> deallocations { 0 };
+    std::atomic<uint64_t> blockingCalls { 0 };
+    std::atomic<uint64_t> overruns { 0 };
+    std::atomic<double> worstLoad { 0.0 };
+    std::atomic<double> totalLoad { 0.0 };
+    std::atomic<uint64_t> buckets[kNumBuckets] = {};
+};
+}
@@ -0,0 +1,29 @@
+#include "Saturation.h"
+
+#include <cmath>
+
+namespace echo
+{
+namespace saturation
+{
+const float* getTanhTable() noexcept
+{
+    struct Table
+    {
+        Table() noexcept
+        {
+            for (int i = 0; i < kTanhTableSize + 2; ++i)
+            {
+                const double x = -kTanhTableRange + (2.0 * kTanhTableRange * i) / kTanhTableSize;
+                values[i] = static_cast<float>(std::tanh(x));
+            }
+        }
+
+        float values[kTanhTableSize + 2];
+    };
+
+    static const Table table;
+    return table.values;
+}
+}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#ifndef ECHO_DEFAULT_DRIVE_QUALITY
+ #define ECHO_DEFAULT_DRIVE_QUALITY 1
+#endif
+
+namespace echo
+{
+/** How the tanh in the feedback-loop drive stage is evaluated.
+
+    - exact:    the C library tanhf, the reference.
+    - rational: [7/6] Padé approximant, clamped at |x| = 4.97.
+                Max absolute error 9.6e-5 (reached at the clamp).
+    - table:    linear interpolation in a 2049-point table over [-8, 8],
+                saturating outside. Max absolute error 6.3e-6.
+*/
+enum class DriveQuality
+{
+    exact,
+    rational,
+    table
+};
+
+constexpr int kNumDriveQualities = 3;
+
+/** Build-time default for the Drive Quality parameter (0 exact, 1 rational, 2 table). */
+constexpr DriveQuality kDefaultDriveQuality = static_cast<DriveQuality>(ECHO_DEFAULT_DRIVE_QUALITY);
+
+namespace saturation
+{
+constexpr float kRationalTanhMaxError = 9.6e-5f;
+constexpr float kTableTanhMaxError = 6.3e-6f;
+
+constexpr int kTanhTableSize = 2048;
+constexpr float kTanhTableRange = 8.0f;
+
+/** kTanhTableSize + 1 points of tanh spanning [-kTanhTableRange, kTanhTableRange],
+    plus one guard point so interpolation at the upper edge stays in bounds.
+*/
+const float* getTanhTable() noexcept;
+
+/** Rational tanh over any lane type (see DriveQuality::rational). */
+template <typename Vec>
+Vec rationalTanh(Vec x) noexcept
+{
+    const Vec limit = Vec::broadcast(4.97f);
+    x = Vec::min(Vec::max(x, Vec::broadcast(0.0f) - limit), limit);
+
+    const Vec x2 = x * x;
+    const Vec numerator = x * Vec::mulAdd(x2, Vec::mulAdd(x2, x2 + Vec::broadcast(378.0f), Vec::broadcast(17325.0f)),
+                                          Vec::broadcast(135135.0f));
+    const Vec denominator = Vec::mulAdd(x2, Vec::mulAdd(x2, Vec::mulAdd(x2, Vec::broadcast(28.0f), Vec::broadcast(3150.0f)),
+                                                        Vec::broadcast(62370.0f)),
+                                        Vec::broadcast(135135.0f));
+    const Vec one = Vec::broadcast(1.0f);
+    return Vec::min(Vec::max(numerator / denominator, Vec::broadcast(0.0f) - one), one);
+}
+}
+}
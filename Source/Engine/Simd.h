@@ -0,0 +1,138 @@
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define ECHO_SIMD_X86 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+ #define ECHO_SIMD_NEON 1
+#endif
+
+namespace echo
+{
+namespace simd
+{
+/** Portable reference implementation of the lane types used by the kernels.
+
+    Every lane type exposes the same small interface: its Sample type,
+    broadcast/load/store (aligned and unaligned), per-lane access for the
+    first two lanes, gather/scatter across one pointer per lane, +, -, *,
+    /, min, max and mulAdd. The kernels are written only against that
+    interface so each instruction set and sample type gets its own
+    instantiation.
+*/
+template <typename T, int Lanes>
+struct ScalarLanes
+{
+    using Sample = T;
+    static constexpr int kNumLanes = Lanes;
+
+    T v[Lanes];
+
+    static ScalarLanes broadcast(T x) noexcept
+    {
+        ScalarLanes r;
+        for (int i = 0; i < Lanes; ++i)
+            r.v[i] = x;
+        return r;
+    }
+
+    static ScalarLanes load(const T* source) noexcept
+    {
+        ScalarLanes r;
+        for (int i = 0; i < Lanes; ++i)
+            r.v[i] = source[i];
+        return r;
+    }
+
+    void store(T* destination) const noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+            destination[i] = v[i];
+    }
+
+    static ScalarLanes loadUnaligned(const T* source) noexcept { return load(source); }
+    void storeUnaligned(T* destination) const noexcept { store(destination); }
+
+    /** Lane i from sources[i][index]. */
+    static ScalarLanes gather(const T* const* sources, int index) noexcept
+    {
+        ScalarLanes r;
+        for (int i = 0; i < Lanes; ++i)
+            r.v[i] = sources[i][index];
+        return r;
+    }
+
+    /** Lane i to destinations[i][index]. */
+    void scatter(T* const* destinations, int index) const noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+            destinations[i][index] = v[i];
+    }
+
+    static ScalarLanes fromPair(T lane0, T lane1) noexcept
+    {
+        ScalarLanes r = broadcast(T(0));
+        r.v[0] = lane0;
+        r.v[1] = lane1;
+        return r;
+    }
+
+    /** Stores lanes 0 and 1 to two consecutive samples. */
+    void storePair(T* destination) const noexcept
+    {
+        destination[0] = v[0];
+        destination[1] = v[1];
+    }
+
+    T lane0() const noexcept { return v[0]; }
+    T lane1() const noexcept { return v[1]; }
+
+    friend ScalarLanes operator+(ScalarLanes a, ScalarLanes b) noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+            a.v[i] += b.v[i];
+        return a;
+    }
+
+    friend ScalarLanes operator-(ScalarLanes a, ScalarLanes b) noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+            a.v[i] -= b.v[i];
+        return a;
+    }
+
+    friend ScalarLanes operator*(ScalarLanes a, ScalarLanes b) noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+            a.v[i] *= b.v[i];
+        return a;
+    }
+
+    friend ScalarLanes operator/(ScalarLanes a, ScalarLanes b) noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+            a.v[i] /= b.v[i];
+        return a;
+    }
+
+    static ScalarLanes min(ScalarLanes a, ScalarLanes b) noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+            a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i];
+        return a;
+    }
+
+    static ScalarLanes max(ScalarLanes a, ScalarLanes b) noexcept
+    {
+        for (int i = 0; i < Lanes; ++i)
+            a.v[i] = a.v[i] < b.v[i] ? b.v[i] : a.v[i];
+        return a;
+    }
+
+    /** a * b + c */
+    static ScalarLanes mulAdd(ScalarLanes a, ScalarLanes b, ScalarLanes c) noexcept
+    {
+        return a * b + c;
+    }
+};
+}
+}
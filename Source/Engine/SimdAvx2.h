@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Simd.h"
+
+// Only include this from translation units compiled with AVX2 and FMA enabled.
+#if ECHO_SIMD_X86
+ #include <immintrin.h>
+
+namespace echo
+{
+namespace simd
+{
+/** Four float lanes using VEX-encoded 128-bit operations and fused multiply-add. */
+struct Avx2Floats
+{
+    using Sample = float;
+    static constexpr int kNumLanes = 4;
+
+    __m128 v;
+
+    static Avx2Floats broadcast(float x) noexcept { return { _mm_set1_ps(x) }; }
+    static Avx2Floats load(const float* source) noexcept { return { _mm_load_ps(source) }; }
+    void store(float* destination) const noexcept { _mm_store_ps(destination, v); }
+    static Avx2Floats loadUnaligned(const float* source) noexcept { return { _mm_loadu_ps(source) }; }
+    void storeUnaligned(float* destination) const noexcept { _mm_storeu_ps(destination, v); }
+
+    static Avx2Floats gather(const float* const* sources, int index) noexcept
+    {
+        return { _mm_setr_ps(sources[0][index], sources[1][index], sources[2][index], sources[3][index]) };
+    }
+
+    void scatter(float* const* destinations, int index) const noexcept
+    {
+        _mm_store_ss(destinations[0] + index, v);
+        _mm_store_ss(destinations[1] + index, _mm_movehdup_ps(v));
+        _mm_store_ss(destinations[2] + index, _mm_movehl_ps(v, v));
+        _mm_store_ss(destinations[3] + index, _mm_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+
+    static Avx2Floats fromPair(float lane0, float lane1) noexcept
+    {
+        return { _mm_insert_ps(_mm_set_ss(lane0), _mm_set_ss(lane1), 0x10) };
+    }
+
+    void storePair(float* destination) const noexcept
+    {
+        _mm_storel_pi(reinterpret_cast<__m64*>(destination), v);
+    }
+
+    float lane0() const noexcept { return _mm_cvtss_f32(v); }
+    float lane1() const noexcept { return _mm_cvtss_f32(_mm_movehdup_ps(v)); }
+
+    friend Avx2Floats operator+(Avx2Floats a, Avx2Floats b) noexcept { return { _mm_add_ps(a.v, b.v) }; }
+    friend Avx2Floats operator-(Avx2Floats a, Avx2Floats b) noexcept { return { _mm_sub_ps(a.v, b.v) }; }
+    friend Avx2Floats operator*(Avx2Floats a, Avx2Floats b) noexcept { return { _mm_mul_ps(a.v, b.v) }; }
+
+    friend Avx2Floats operator/(Avx2Floats a, Avx2Floats b) noexcept { return { _mm_div_ps(a.v, b.v) }; }
+
+    static Avx2Floats min(Avx2Floats a, Avx2Floats b) noexcept { return { _mm_min_ps(a.v, b.v) }; }
+    static Avx2Floats max(Avx2Floats a, Avx2Floats b) noexcept { return { _mm_max_ps(a.v, b.v) }; }
+
+    static Avx2Floats mulAdd(Avx2Floats a, Avx2Floats b, Avx2Floats c) noexcept
+    {
+        return { _mm_fmadd_ps(a.v, b.v, c.v) };
+    }
+};
+
+/** Four double lanes in an AVX register, with fused multiply-add. */
+struct Avx2Doubles
+{
+    using Sample = double;
+    static constexpr int kNumLanes = 4;
+
+    __m256d v;
+
+    static Avx2Doubles broadcast(double x) noexcept { return { _mm256_set1_pd(x) }; }
+    static Avx2Doubles load(const double* source) noexcept { return { _mm256_load_pd(source) }; }
+    void store(double* destination) const noexcept { _mm256_store_pd(destination, v); }
+    static Avx2Doubles loadUnaligned(const double* source) noexcept { return { _mm256_loadu_pd(source) }; }
+    void storeUnaligned(double* destination) const noexcept { _mm256_storeu_pd(destination, v); }
+
+    static Avx2Doubles gather(const double* const* sources, int index) noexcept
+    {
+        return { _mm256_setr_pd(sources[0][index], sources[1][index], sources[2][index], sources[3][index]) };
+    }
+
+    void scatter(double* const* destinations, int index) const noexcept
+    {
+        const __m128d low = _mm256_castpd256_pd128(v);
+        const __m128d high = _mm256_extractf128_pd(v, 1);
+        _mm_storel_pd(destinations[0] + index, low);
+        _mm_storeh_pd(destinations[1] + index, low);
+        _mm_storel_pd(destinations[2] + index, high);
+        _mm_storeh_pd(destinations[3] + index, high);
+    }
+
+    static Avx2Doubles fromPair(double lane0, double lane1) noexcept
+    {
+        return { _mm256_setr_pd(lane0, lane1, 0.0, 0.0) };
+    }
+
+    void storePair(double* destination) const noexcept { _mm_storeu_pd(destination, _mm256_castpd256_pd128(v)); }
+
+    double lane0() const noexcept { return _mm_cvtsd_f64(_mm256_castpd256_pd128(v)); }
+    double lane1() const noexcept
+    {
+        const __m128d low = _mm256_castpd256_pd128(v);
+        return _mm_cvtsd_f64(_mm_unpackhi_pd(low, low));
+    }
+
+    friend Avx2Doubles operator+(Avx2Doubles a, Avx2Doubles b) noexcept { return { _mm256_add_pd(a.v, b.v) }; }
+    friend Avx2Doubles operator-(Avx2Doubles a, Avx2Doubles b) noexcept { return { _mm256_sub_pd(a.v, b.v) }; }
+    friend Avx2Doubles operator*(Avx2Doubles a, Avx2Doubles b) noexcept { return { _mm256_mul_pd(a.v, b.v) }; }
+
+    friend Avx2Doubles operator/(Avx2Doubles a, Avx2Doubles b) noexcept { return { _mm256_div_pd(a.v, b.v) }; }
+
+    static Avx2Doubles min(Avx2Doubles a, Avx2Doubles b) noexcept { return { _mm256_min_pd(a.v, b.v) }; }
+    static Avx2Doubles max(Avx2Doubles a, Avx2Doubles b) noexcept { return { _mm256_max_pd(a.v, b.v) }; }
+
+    static Avx2Doubles mulAdd(Avx2Doubles a, Avx2Doubles b, Avx2Doubles c) noexcept
+    {
+        return { _mm256_fmadd_pd(a.v, b.v, c.v) };
+    }
+};
+}
+}
+#endif
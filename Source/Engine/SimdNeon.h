@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Simd.h"
+
+#if ECHO_SIMD_NEON
+ #include <arm_neon.h>
+
+namespace echo
+{
+namespace simd
+{
+/** Four float lanes in a NEON register. */
+struct NeonFloats
+{
+    using Sample = float;
+    static constexpr int kNumLanes = 4;
+
+    float32x4_t v;
+
+    static NeonFloats broadcast(float x) noexcept { return { vdupq_n_f32(x) }; }
+    static NeonFloats load(const float* source) noexcept { return { vld1q_f32(source) }; }
+    void store(float* destination) const noexcept { vst1q_f32(destination, v); }
+    static NeonFloats loadUnaligned(const float* source) noexcept { return load(source); }
+    void storeUnaligned(float* destination) const noexcept { store(destination); }
+
+    static NeonFloats gather(const float* const* sources, int index) noexcept
+    {
+        float32x4_t r = vdupq_n_f32(sources[0][index]);
+        r = vsetq_lane_f32(sources[1][index], r, 1);
+        r = vsetq_lane_f32(sources[2][index], r, 2);
+        r = vsetq_lane_f32(sources[3][index], r, 3);
+        return { r };
+    }
+
+    void scatter(float* const* destinations, int index) const noexcept
+    {
+        vst1q_lane_f32(destinations[0] + index, v, 0);
+        vst1q_lane_f32(destinations[1] + index, v, 1);
+        vst1q_lane_f32(destinations[2] + index, v, 2);
+        vst1q_lane_f32(destinations[3] + index, v, 3);
+    }
+
+    static NeonFloats fromPair(float lane0, float lane1) noexcept
+    {
+        const float32x2_t pair = vset_lane_f32(lane1, vdup_n_f32(lane0), 1);
+        return { vcombine_f32(pair, vdup_n_f32(0.0f)) };
+    }
+
+    void storePair(float* destination) const noexcept { vst1_f32(destination, vget_low_f32(v)); }
+
+    float lane0() const noexcept { return vgetq_lane_f32(v, 0); }
+    float lane1() const noexcept { return vgetq_lane_f32(v, 1); }
+
+    friend NeonFloats operator+(NeonFloats a, NeonFloats b) noexcept { return { vaddq_f32(a.v, b.v) }; }
+    friend NeonFloats operator-(NeonFloats a, NeonFloats b) noexcept { return { vsubq_f32(a.v, b.v) }; }
+    friend NeonFloats operator*(NeonFloats a, NeonFloats b) noexcept { return { vmulq_f32(a.v, b.v) }; }
+
+   #if defined(__aarch64__) || defined(_M_ARM64)
+    friend NeonFloats operator/(NeonFloats a, NeonFloats b) noexcept { return { vdivq_f32(a.v, b.v) }; }
+   #else
+    friend NeonFloats operator/(NeonFloats a, NeonFloats b) noexcept
+    {
+        // Two Newton-Raphson steps on the reciprocal estimate.
+        float32x4_t reciprocal = vrecpeq_f32(b.v);
+        reciprocal = vmulq_f32(vrecpsq_f32(b.v, reciprocal), reciprocal);
+        reciprocal = vmulq_f32(vrecpsq_f32(b.v, reciprocal), reciprocal);
+        return { vmulq_f32(a.v, reciprocal) };
+    }
+   #endif
+
+    static NeonFloats min(NeonFloats a, NeonFloats b) noexcept { return { vminq_f32(a.v, b.v) }; }
+    static NeonFloats max(NeonFloats a, NeonFloats b) noexcept { return { vmaxq_f32(a.v, b.v) }; }
+
+    static NeonFloats mulAdd(NeonFloats a, NeonFloats b, NeonFloats c) noexcept
+    {
+        return { vmlaq_f32(c.v, a.v, b.v) };
+    }
+};
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+ #define ECHO_SIMD_NEON_DOUBLES 1
+
+/** Two double lanes in a NEON register (AArch64 only). */
+struct NeonDoubles
+{
+    using Sample = double;
+    static constexpr int kNumLanes = 2;
+
+    float64x2_t v;
+
+    static NeonDoubles broadcast(double x) noexcept { return { vdupq_n_f64(x) }; }
+    static NeonDoubles load(const double* source) noexcept { return { vld1q_f64(source) }; }
+    void store(double* destination) const noexcept { vst1q_f64(destination, v); }
+    static NeonDoubles loadUnaligned(const double* source) noexcept { return load(source); }
+    void storeUnaligned(double* destination) const noexcept { store(destination); }
+
+    static NeonDoubles gather(const double* const* sources, int index) noexcept
+    {
+        return fromPair(sources[0][index], sources[1][index]);
+    }
+
+    void scatter(double* const* destinations, int index) const noexcept
+    {
+        vst1q_lane_f64(destinations[0] + index, v, 0);
+        vst1q_lane_f64(destinations[1] + index, v, 1);
+    }
+
+    static NeonDoubles fromPair(double lane0, double lane1) noexcept
+    {
+        return { vsetq_lane_f64(lane1, vdupq_n_f64(lane0), 1) };
+    }
+
+    void storePair(double* destination) const noexcept { vst1q_f64(destination, v); }
+
+    double lane0() const noexcept { return vgetq_lane_f64(v, 0); }
+    double lane1() const noexcept { return vgetq_lane_f64(v, 1); }
+
+    friend NeonDoubles operator+(NeonDoubles a, NeonDoubles b) noexcept { return { vaddq_f64(a.v, b.v) }; }
+    friend NeonDoubles operator-(NeonDoubles a, NeonDoubles b) noexcept { return { vsubq_f64(a.v, b.v) }; }
+    friend NeonDoubles operator*(NeonDoubles a, NeonDoubles b) noexcept { return { vmulq_f64(a.v, b.v) }; }
+    friend NeonDoubles operator/(NeonDoubles a, NeonDoubles b) noexcept { return { vdivq_f64(a.v, b.v) }; }
+
+    static NeonDoubles min(NeonDoubles a, NeonDoubles b) noexcept { return { vminq_f64(a.v, b.v) }; }
+    static NeonDoubles max(NeonDoubles a, NeonDoubles b) noexcept { return { vmaxq_f64(a.v, b.v) }; }
+
+    static NeonDoubles mulAdd(NeonDoubles a, NeonDoubles b, NeonDoubles c) noexcept
+    {
+        return { vfmaq_f64(c.v, a.v, b.v) };
+    }
+};
+#endif
+}
+}
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Simd.h"
+
+#if ECHO_SIMD_X86
+ #include <emmintrin.h>
+
+namespace echo
+{
+namespace simd
+{
+/** Four float lanes in an SSE2 register. */
+struct Sse2Floats
+{
+    using Sample = float;
+    static constexpr int kNumLanes = 4;
+
+    __m128 v;
+
+    static Sse2Floats broadcast(float x) noexcept { return { _mm_set1_ps(x) }; }
+    static Sse2Floats load(const float* source) noexcept { return { _mm_load_ps(source) }; }
+    void store(float* destination) const noexcept { _mm_store_ps(destination, v); }
+    static Sse2Floats loadUnaligned(const float* source) noexcept { return { _mm_loadu_ps(source) }; }
+    void storeUnaligned(float* destination) const noexcept { _mm_storeu_ps(destination, v); }
+
+    static Sse2Floats gather(const float* const* sources, int index) noexcept
+    {
+        return { _mm_setr_ps(sources[0][index], sources[1][index], sources[2][index], sources[3][index]) };
+    }
+
+    void scatter(float* const* destinations, int index) const noexcept
+    {
+        _mm_store_ss(destinations[0] + index, v);
+        _mm_store_ss(destinations[1] + index, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+        _mm_store_ss(destinations[2] + index, _mm_movehl_ps(v, v));
+        _mm_store_ss(destinations[3] + index, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+
+    static Sse2Floats fromPair(float lane0, float lane1) noexcept
+    {
+        return { _mm_unpacklo_ps(_mm_set_ss(lane0), _mm_set_ss(lane1)) };
+    }
+
+    void storePair(float* destination) const noexcept
+    {
+        _mm_storel_pi(reinterpret_cast<__m64*>(destination), v);
+    }
+
+    float lane0() const noexcept { return _mm_cvtss_f32(v); }
+    float lane1() const noexcept { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))); }
+
+    friend Sse2Floats operator+(Sse2Floats a, Sse2Floats b) noexcept { return { _mm_add_ps(a.v, b.v) }; }
+    friend Sse2Floats operator-(Sse2Floats a, Sse2Floats b) noexcept { return { _mm_sub_ps(a.v, b.v) }; }
+    friend Sse2Floats operator*(Sse2Floats a, Sse2Floats b) noexcept { return { _mm_mul_ps(a.v, b.v) }; }
+
+    friend Sse2Floats operator/(Sse2Floats a, Sse2Floats b) noexcept { return { _mm_div_ps(a.v, b.v) }; }
+
+    static Sse2Floats min(Sse2Floats a, Sse2Floats b) noexcept { return { _mm_min_ps(a.v, b.v) }; }
+    static Sse2Floats max(Sse2Floats a, Sse2Floats b) noexcept { return { _mm_max_ps(a.v, b.v) }; }
+
+    static Sse2Floats mulAdd(Sse2Floats a, Sse2Floats b, Sse2Floats c) noexcept
+    {
+        return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) };
+    }
+};
+
+/** Two double lanes in an SSE2 register. */
+struct Sse2Doubles
+{
+    using Sample = double;
+    static constexpr int kNumLanes = 2;
+
+    __m128d v;
+
+    static Sse2Doubles broadcast(double x) noexcept { return { _mm_set1_pd(x) }; }
+    static Sse2Doubles load(const double* source) noexcept { return { _mm_load_pd(source) }; }
+    void store(double* destination) const noexcept { _mm_store_pd(destination, v); }
+    static Sse2Doubles loadUnaligned(const double* source) noexcept { return { _mm_loadu_pd(source) }; }
+    void storeUnaligned(double* destination) const noexcept { _mm_storeu_pd(destination, v); }
+
+    static Sse2Doubles gather(const double* const* sources, int index) noexcept
+    {
+        return { _mm_setr_pd(sources[0][index], sources[1][index]) };
+    }
+
+    void scatter(double* const* destinations, int index) const noexcept
+    {
+        _mm_storel_pd(destinations[0] + index, v);
+        _mm_storeh_pd(destinations[1] + index, v);
+    }
+
+    static Sse2Doubles fromPair(double lane0, double lane1) noexcept { return { _mm_set_pd(lane1, lane0) }; }
+    void storePair(double* destination) const noexcept { _mm_storeu_pd(destination, v); }
+
+    double lane0() const noexcept { return _mm_cvtsd_f64(v); }
+    double lane1() const noexcept { return _mm_cvtsd_f64(_mm_unpackhi_pd(v, v)); }
+
+    friend Sse2Doubles operator+(Sse2Doubles a, Sse2Doubles b) noexcept { return { _mm_add_pd(a.v, b.v) }; }
+    friend Sse2Doubles operator-(Sse2Doubles a, Sse2Doubles b) noexcept { return { _mm_sub_pd(a.v, b.v) }; }
+    friend Sse2Doubles operator*(Sse2Doubles a, Sse2Doubles b) noexcept { return { _mm_mul_pd(a.v, b.v) }; }
+
+    friend Sse2Doubles operator/(Sse2Doubles a, Sse2Doubles b) noexcept { return { _mm_div_pd(a.v, b.v) }; }
+
+    static Sse2Doubles min(Sse2Doubles a, Sse2Doubles b) noexcept { return { _mm_min_pd(a.v, b.v) }; }
+    static Sse2Doubles max(Sse2Doubles a, Sse2Doubles b) noexcept { return { _mm_max_pd(a.v, b.v) }; }
+
+    static Sse2Doubles mulAdd(Sse2Doubles a, Sse2Doubles b, Sse2Doubles c) noexcept
+    {
+        return { _mm_add_pd(_mm_mul_pd(a.v, b.v), c.v) };
+    }
+};
+}
+}
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+namespace echo
+{
+/** Steepness of the feedback-loop LowCut and HighCut filters. */
+enum class FilterSlope
+{
+    db12,   // one 2-pole Butterworth stage
+    db24    // two cascaded stages, a 4-pole Butterworth
+};
+
+constexpr int kNumFilterSlopes = 2;
+
+namespace svf
+{
+constexpr int kMaxStages = 2;
+constexpr int kNumLanes = 4;
+
+/** Highest cutoff, as a fraction of the sample rate; tan() has its pole at 0.5. */
+constexpr double kMaxCutoffRatio = 0.49;
+
+/** tan(x) for 0 <= x < pi/2. A [5/4] Padé approximant on [0, pi/4], with
+    tan(x) = 1 / tan(pi/2 - x) above; max relative error 3e-6, which moves
+    a cutoff by far less than a cent.
+*/
+inline double fastTan(double x) noexcept
+{
+    constexpr double quarterPi = 0.78539816339744830962;
+    constexpr double halfPi = 1.57079632679489661923;
+
+    const bool reflected = x > quarterPi;
+    const double y = reflected ? halfPi - x : x;
+    const double y2 = y * y;
+    const double tanY = y * (945.0 + y2 * (-105.0 + y2)) / (945.0 + y2 * (-420.0 + y2 * 15.0));
+    return reflected ? 1.0 / tanY : tanY;
+}
+
+/** Damping (1/Q) of each stage for a Butterworth response of the given slope. */
+inline double getDamping(FilterSlope slope, int stage) noexcept
+{
+    if (slope == FilterSlope::db12)
+        return 1.41421356237309504880;               // 1 / 0.7071
+
+    return stage == 0 ? 1.84775906502257351225       // 2 cos(pi / 8)
+                      : 0.76536686473017954346;      // 2 cos(3 pi / 8)
+}
+}
+
+/** Coefficients of one topology-preserving-transform state-variable filter
+    stage (Zavalishin, "The Art of VA Filter Design"; Simper's
+    formulation), stored at the engine's sample type.
+*/
+template <typename Sample>
+struct SvfCoefficients
+{
+    Sample a1 = 1;
+    Sample a2 = 0;
+    Sample a3 = 0;
+    Sample k = 0;
+
+    /** g is tan(pi * cutoff / sampleRate), k the damping. */
+    static SvfCoefficients make(double g, double k) noexcept
+    {
+        const double a1 = 1.0 / (1.0 + g * (g + k));
+
+        SvfCoefficients c;
+        c.a1 = static_cast<Sample>(a1);
+        c.a2 = static_cast<Sample>(g * a1);
+        c.a3 = static_cast<Sample>(g * g * a1);
+        c.k = static_cast<Sample>(k);
+        return c;
+    }
+};
+
+/** A bank of TPT state-variable filters, up to svf::kMaxStages cascaded,
+    sharing one set of coefficients per stage.
+
+    The state is the two integrators' charge, which stays meaningful when
+    the coefficients change, so the cutoff can jump or sweep every
+    sub-block without the clicks or blow-ups of a direct-form biquad. The
+    response matches the bilinear-transform Butterworth. Each channel's
+    state sits in its own lane, so the kernels run all channels of a group
+    with one set of SIMD operations.
+*/
+template <typename Sample>
+struct SvfLanes
+{
+    static constexpr int kNumLanes = svf::kNumLanes;
+
+    SvfCoefficients<Sample> stages[svf::kMaxStages];
+    alignas(kNumLanes * sizeof(Sample)) Sample ic1[svf::kMaxStages][kNumLanes]{};
+    alignas(kNumLanes * sizeof(Sample)) Sample ic2[svf::kMaxStages][kNumLanes]{};
+
+    /** Sets every stage for a cutoff; the slope picks the damping. */
+    void setCutoff(double sampleRate, double frequency, FilterSlope slope) noexcept
+    {
+        constexpr double pi = 3.14159265358979323846;
+        const double ratio = frequency / sampleRate;
+        const double clamped = ratio < 0.0 ? 0.0 : (ratio > svf::kMaxCutoffRatio ? svf::kMaxCutoffRatio : ratio);
+        const double g = svf::fastTan(pi * clamped);
+
+        for (int stage = 0; stage < svf::kMaxStages; ++stage)
+            stages[stage] = SvfCoefficients<Sample>::make(g, svf::getDamping(slope, stage));
+    }
+
+    void copyCoefficients(const SvfLanes& other) noexcept
+    {
+        for (int stage = 0; stage < svf::kMaxStages; ++stage)
+            stages[stage] = other.stages[stage];
+    }
+
+    void reset() noexcept
+    {
+        for (int stage = 0; stage < svf::kMaxStages; ++stage)
+            resetStage(stage);
+    }
+
+    void resetStage(int stage) noexcept
+    {
+        for (int lane = 0; lane < kNumLanes; ++lane)
+            ic1[stage][lane] = ic2[stage][lane] = 0;
+    }
+};
+}
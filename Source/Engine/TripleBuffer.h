@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+
+namespace echo
+{
+/** Wait-free single-producer, single-consumer hand-over of the latest value.
+
+    The producer fills getWriteBuffer() and calls publish(); the consumer
+    calls update() and, if it returns true, reads getReadBuffer(). Neither
+    side ever waits or allocates. Intermediate values are dropped if the
+    producer publishes faster than the consumer reads. A write buffer holds
+    stale data from an earlier publish, so the producer must overwrite every
+    field it uses.
+*/
+template <typename T>
+class TripleBuffer
+{
+public:
+    T& getWriteBuffer() noexcept { return slots[writeIndex]; }
+
+    void publish() noexcept
+    {
+        writeIndex = shared.exchange(writeIndex | kFreshFlag, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    /** Swaps in the newest published value; false if nothing new arrived. */
+    bool update() noexcept
+    {
+        if ((shared.load(std::memory_order_relaxed) & kFreshFlag) == 0)
+            return false;
+
+        readIndex = shared.exchange(readIndex, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const noexcept { return slots[readIndex]; }
+
+private:
+    static constexpr int kIndexMask = 3;
+    static constexpr int kFreshFlag = 4;
+
+    T slots[3] {};
+    std::atomic<int> shared { 1 };
+    int writeIndex = 0;
+    int readIndex = 2;
+};
+}
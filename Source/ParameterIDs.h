@@ -1,5 +1,7 @@
 #pragma once
 
+#include <JuceHeader.h>
+
 namespace ParameterIDs
 {
 constexpr auto timeMs = "timeMs";
@@ -9,7 +11,36 @@ constexpr auto feedback = "feedback";
 constexpr auto mix = "mix";
 constexpr auto lowCut = "lowCut";
 constexpr auto highCut = "highCut";
+constexpr auto filterSlope = "filterSlope";
 constexpr auto pingPong = "pingPong";
+constexpr auto interpolation = "interpolation";
 constexpr auto drive = "drive";
+constexpr auto driveQuality = "driveQuality";
+constexpr auto oversampling = "oversampling";
 constexpr auto output = "output";
+constexpr auto delayStorage = "delayStorage";
+constexpr auto numTaps = "numTaps";
+constexpr auto modDepth = "modDepth";
+constexpr auto modRate = "modRate";
+constexpr auto modSync = "modSync";
+constexpr auto modDivision = "modDivision";
+constexpr auto modDrift = "modDrift";
+constexpr auto modSpread = "modSpread";
+constexpr auto diffusion = "diffusion";
+constexpr auto diffusionSize = "diffusionSize";
+constexpr auto timeScale = "timeScale";
+
+// Per-tap parameters are "tap<n>" plus one of these, counting taps from 1
+// as the user sees them ("tap2Time"). Tap 1 uses timeMs and syncDivision.
+constexpr auto tapTimeSuffix = "Time";
+constexpr auto tapDivisionSuffix = "Division";
+constexpr auto tapGainSuffix = "Gain";
+constexpr auto tapPanSuffix = "Pan";
+constexpr auto tapSendSuffix = "Send";
+
+/** The ID of a per-tap parameter, for tap counted from 0. */
+inline juce::String getTapParameterID(int tap, const char* suffix)
+{
+    return "tap" + juce::String(tap + 1) + suffix;
+}
 }
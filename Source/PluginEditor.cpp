@@ -23,13 +23,14 @@ EchoByHdbAudioProcessorEditor::EchoByHdbAudioProcessorEditor(EchoByHdbAudioProce
     : AudioProcessorEditor(&p)
     , processor(p)
 {
-    setSize(720, 420);
+    setSize(880, 600);
 
     titleLabel.setText("Echo by HDB", juce::dontSendNotification);
     titleLabel.setJustificationType(juce::Justification::centred);
     titleLabel.setFont(juce::Font(22.0f, juce::Font::bold));
     titleLabel.setColour(juce::Label::textColourId, juce::Colours::white);
     addAndMakeVisible(titleLabel);
+    addAndMakeVisible(echoDisplay);
 
     configureKnob(timeSlider, "Time", "Delay time in milliseconds or sync division");
     configureKnob(feedbackSlider, "Feedback", "Feedback amount");
@@ -37,17 +38,34 @@ EchoByHdbAudioProcessorEditor::EchoByHdbAudioProcessorEditor(EchoByHdbAudioProce
     configureKnob(lowCutSlider, "LowCut", "High-pass filter in feedback loop");
     configureKnob(highCutSlider, "HighCut", "Low-pass filter in feedback loop");
     configureKnob(driveSlider, "Drive", "Soft saturation in feedback loop");
+    configureKnob(modDepthSlider, "Mod Depth", "Delay time modulation depth: wow and chorus on the repeats");
+    configureKnob(modRateSlider, "Mod Rate", "Delay time modulation rate");
     configureKnob(outputSlider, "Output", "Output gain");
 
     syncButton.setButtonText("Sync");
     syncButton.setTooltip("Sync delay time to host tempo");
 
     pingPongButton.setButtonText("PingPong");
-    pingPongButton.setTooltip("Ping-pong stereo feedback");
+    pingPongButton.setTooltip("Ping-pong feedback between left and right channels");
 
     syncDivisionBox.addItemList({ "1/1", "1/2", "1/4", "1/8", "1/16", "1/8T", "1/16T", "1/8D", "1/16D" }, 1);
     syncDivisionBox.setTooltip("Tempo sync division");
 
+    filterSlopeBox.addItemList({ "12 dB/oct", "24 dB/oct" }, 1);
+    filterSlopeBox.setTooltip("Steepness of the LowCut and HighCut filters");
+
+    interpolationBox.addItemList({ "Linear", "Hermite", "Lagrange", "Allpass" }, 1);
+    interpolationBox.setTooltip("Fractional delay interpolation: higher orders keep the repeats brighter");
+
+    driveQualityBox.addItemList({ "Exact", "Rational", "Table" }, 1);
+    driveQualityBox.setTooltip("Saturation accuracy vs. CPU cost");
+
+    oversamplingBox.addItemList({ "Off", "2x", "4x" }, 1);
+    oversamplingBox.setTooltip("Oversample the feedback saturation to reduce aliasing");
+
+    numTapsBox.addItemList({ "1 Tap", "2 Taps", "3 Taps", "4 Taps", "5 Taps", "6 Taps", "7 Taps", "8 Taps" }, 1);
+    numTapsBox.setTooltip("Read heads on the delay line; each tap's time, gain, pan and send are host parameters");
+
     configureLabel(timeValueLabel, "Time: 400 ms");
     configureLabel(feedbackValueLabel, "Feedback: 35 %");
     configureLabel(mixValueLabel, "Mix: 35 %");
@@ -58,14 +76,29 @@ EchoByHdbAudioProcessorEditor::EchoByHdbAudioProcessorEditor(EchoByHdbAudioProce
     addAndMakeVisible(lowCutSlider);
     addAndMakeVisible(highCutSlider);
     addAndMakeVisible(driveSlider);
+    addAndMakeVisible(modDepthSlider);
+    addAndMakeVisible(modRateSlider);
     addAndMakeVisible(outputSlider);
     addAndMakeVisible(syncButton);
     addAndMakeVisible(pingPongButton);
     addAndMakeVisible(syncDivisionBox);
+    addAndMakeVisible(filterSlopeBox);
+    addAndMakeVisible(interpolationBox);
+    addAndMakeVisible(driveQualityBox);
+    addAndMakeVisible(oversamplingBox);
+    addAndMakeVisible(numTapsBox);
     addAndMakeVisible(timeValueLabel);
     addAndMakeVisible(feedbackValueLabel);
     addAndMakeVisible(mixValueLabel);
 
+    if constexpr (echo::RealtimeMonitor::kEnabled)
+    {
+        realtimeLabel.setJustificationType(juce::Justification::centredLeft);
+        realtimeLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+        realtimeLabel.setFont(juce::Font(12.0f));
+        addAndMakeVisible(realtimeLabel);
+    }
+
     auto& apvts = processor.getAPVTS();
     timeAttachment = std::make_unique<SliderAttachment>(apvts, ParameterIDs::timeMs, timeSlider);
     feedbackAttachment = std::make_unique<SliderAttachment>(apvts, ParameterIDs::feedback, feedbackSlider);
@@ -73,12 +106,25 @@ EchoByHdbAudioProcessorEditor::EchoByHdbAudioProcessorEditor(EchoByHdbAudioProce
     lowCutAttachment = std::make_unique<SliderAttachment>(apvts, ParameterIDs::lowCut, lowCutSlider);
     highCutAttachment = std::make_unique<SliderAttachment>(apvts, ParameterIDs::highCut, highCutSlider);
     driveAttachment = std::make_unique<SliderAttachment>(apvts, ParameterIDs::drive, driveSlider);
+    modDepthAttachment = std::make_unique<SliderAttachment>(apvts, ParameterIDs::modDepth, modDepthSlider);
+    modRateAttachment = std::make_unique<SliderAttachment>(apvts, ParameterIDs::modRate, modRateSlider);
     outputAttachment = std::make_unique<SliderAttachment>(apvts, ParameterIDs::output, outputSlider);
     syncAttachment = std::make_unique<ButtonAttachment>(apvts, ParameterIDs::sync, syncButton);
     pingPongAttachment = std::make_unique<ButtonAttachment>(apvts, ParameterIDs::pingPong, pingPongButton);
     syncDivisionAttachment = std::make_unique<ComboBoxAttachment>(apvts, ParameterIDs::syncDivision, syncDivisionBox);
+    filterSlopeAttachment = std::make_unique<ComboBoxAttachment>(apvts, ParameterIDs::filterSlope, filterSlopeBox);
+    interpolationAttachment = std::make_unique<ComboBoxAttachment>(apvts, ParameterIDs::interpolation, interpolationBox);
+    driveQualityAttachment = std::make_unique<ComboBoxAttachment>(apvts, ParameterIDs::driveQuality, driveQualityBox);
+    oversamplingAttachment = std::make_unique<ComboBoxAttachment>(apvts, ParameterIDs::oversampling, oversamplingBox);
+    numTapsAttachment = std::make_unique<ComboBoxAttachment>(apvts, ParameterIDs::numTaps, numTapsBox);
+
+    processor.setMeteringActive(true);
+    startTimerHz(30);
+}
 
-    startTimerHz(12);
+EchoByHdbAudioProcessorEditor::~EchoByHdbAudioProcessorEditor()
+{
+    processor.setMeteringActive(false);
 }
 
 void EchoByHdbAudioProcessorEditor::paint(juce::Graphics& g)
@@ -99,6 +145,8 @@ void EchoByHdbAudioProcessorEditor::resized()
     feedbackValueLabel.setBounds(valueArea.removeFromLeft(area.getWidth() / 2));
     mixValueLabel.setBounds(valueArea);
 
+    echoDisplay.setBounds(area.removeFromTop(100).reduced(0, 4));
+
     auto topRow = area.removeFromTop(160);
     auto bottomRow = area.removeFromTop(160);
 
@@ -108,22 +156,35 @@ void EchoByHdbAudioProcessorEditor::resized()
     mixSlider.setBounds(topRow.removeFromLeft(knobWidth).reduced(8));
     outputSlider.setBounds(topRow.removeFromLeft(knobWidth).reduced(8));
 
-    knobWidth = bottomRow.getWidth() / 3;
+    knobWidth = bottomRow.getWidth() / 5;
     lowCutSlider.setBounds(bottomRow.removeFromLeft(knobWidth).reduced(8));
     highCutSlider.setBounds(bottomRow.removeFromLeft(knobWidth).reduced(8));
     driveSlider.setBounds(bottomRow.removeFromLeft(knobWidth).reduced(8));
-
-    auto buttonArea = area;
-    syncButton.setBounds(buttonArea.removeFromLeft(120));
-    syncDivisionBox.setBounds(buttonArea.removeFromLeft(120));
-    pingPongButton.setBounds(buttonArea.removeFromLeft(120));
+    modDepthSlider.setBounds(bottomRow.removeFromLeft(knobWidth).reduced(8));
+    modRateSlider.setBounds(bottomRow.removeFromLeft(knobWidth).reduced(8));
+
+    auto buttonArea = area.removeFromTop(32);
+    realtimeLabel.setBounds(area);
+
+    syncButton.setBounds(buttonArea.removeFromLeft(100));
+    syncDivisionBox.setBounds(buttonArea.removeFromLeft(110));
+    pingPongButton.setBounds(buttonArea.removeFromLeft(100));
+    filterSlopeBox.setBounds(buttonArea.removeFromLeft(100));
+    interpolationBox.setBounds(buttonArea.removeFromLeft(120));
+    driveQualityBox.setBounds(buttonArea.removeFromLeft(110));
+    oversamplingBox.setBounds(buttonArea.removeFromLeft(110));
+    numTapsBox.setBounds(buttonArea.removeFromLeft(80));
 }
 
 void EchoByHdbAudioProcessorEditor::timerCallback()
 {
+    if (const auto* snapshot = processor.pollMeters())
+        echoDisplay.update(*snapshot);
+
     const auto& apvts = processor.getAPVTS();
     const bool syncEnabled = apvts.getRawParameterValue(ParameterIDs::sync)->load() > 0.5f;
-    const float timeValue = apvts.getRawParameterValue(ParameterIDs::timeMs)->load();
+    const float timeValue = apvts.getRawParameterValue(ParameterIDs::timeMs)->load()
+                          * EchoByHdbAudioProcessor::getTimeScale(static_cast<int>(apvts.getRawParameterValue(ParameterIDs::timeScale)->load()));
     const int divisionIndex = static_cast<int>(apvts.getRawParameterValue(ParameterIDs::syncDivision)->load());
 
     if (syncEnabled)
@@ -142,4 +203,15 @@ void EchoByHdbAudioProcessorEditor::timerCallback()
 
     feedbackValueLabel.setText("Feedback: " + juce::String(feedbackValue, 1) + " %", juce::dontSendNotification);
     mixValueLabel.setText("Mix: " + juce::String(mixValue, 1) + " %", juce::dontSendNotification);
+
+    if constexpr (echo::RealtimeMonitor::kEnabled)
+    {
+        const auto stats = processor.getRealtimeMonitor().getSnapshot();
+        realtimeLabel.setText("RT guard: " + juce::String(static_cast<juce::int64>(stats.allocations)) + " allocs, "
+                                  + juce::String(static_cast<juce::int64>(stats.blockingCalls)) + " blocking calls, "
+                                  + "p99 " + juce::String(stats.getPercentileLoad(99.0) * 100.0, 0) + " %, "
+                                  + "worst " + juce::String(stats.worstLoad * 100.0, 0) + " %, "
+                                  + juce::String(static_cast<juce::int64>(stats.overruns)) + " overruns",
+                              juce::dontSendNotification);
+    }
 }
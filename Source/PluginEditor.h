@@ -1,6 +1,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "EchoDisplay.h"
 #include "PluginProcessor.h"
 
 class EchoByHdbAudioProcessorEditor final : public juce::AudioProcessorEditor,
@@ -8,7 +9,7 @@ class EchoByHdbAudioProcessorEditor final : public juce::AudioProcessorEditor,
 {
 public:
     explicit EchoByHdbAudioProcessorEditor(EchoByHdbAudioProcessor&);
-    ~EchoByHdbAudioProcessorEditor() override = default;
+    ~EchoByHdbAudioProcessorEditor() override;
 
     void paint(juce::Graphics&) override;
     void resized() override;
@@ -19,6 +20,7 @@ private:
     EchoByHdbAudioProcessor& processor;
 
     juce::Label titleLabel;
+    EchoDisplay echoDisplay;
 
     juce::Slider timeSlider;
     juce::Slider feedbackSlider;
@@ -26,15 +28,23 @@ private:
     juce::Slider lowCutSlider;
     juce::Slider highCutSlider;
     juce::Slider driveSlider;
+    juce::Slider modDepthSlider;
+    juce::Slider modRateSlider;
     juce::Slider outputSlider;
 
     juce::ToggleButton syncButton;
     juce::ToggleButton pingPongButton;
     juce::ComboBox syncDivisionBox;
+    juce::ComboBox filterSlopeBox;
+    juce::ComboBox interpolationBox;
+    juce::ComboBox driveQualityBox;
+    juce::ComboBox oversamplingBox;
+    juce::ComboBox numTapsBox;
 
     juce::Label timeValueLabel;
     juce::Label feedbackValueLabel;
     juce::Label mixValueLabel;
+    juce::Label realtimeLabel;
 
     using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
     using ButtonAttachment = juce::AudioProcessorValueTreeState::ButtonAttachment;
@@ -46,10 +56,17 @@ private:
     std::unique_ptr<SliderAttachment> lowCutAttachment;
     std::unique_ptr<SliderAttachment> highCutAttachment;
     std::unique_ptr<SliderAttachment> driveAttachment;
+    std::unique_ptr<SliderAttachment> modDepthAttachment;
+    std::unique_ptr<SliderAttachment> modRateAttachment;
     std::unique_ptr<SliderAttachment> outputAttachment;
     std::unique_ptr<ButtonAttachment> syncAttachment;
     std::unique_ptr<ButtonAttachment> pingPongAttachment;
     std::unique_ptr<ComboBoxAttachment> syncDivisionAttachment;
+    std::unique_ptr<ComboBoxAttachment> filterSlopeAttachment;
+    std::unique_ptr<ComboBoxAttachment> interpolationAttachment;
+    std::unique_ptr<ComboBoxAttachment> driveQualityAttachment;
+    std::unique_ptr<ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<ComboBoxAttachment> numTapsAttachment;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EchoByHdbAudioProcessorEditor)
 };
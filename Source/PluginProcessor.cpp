@@ -4,35 +4,103 @@
 
 namespace
 {
-constexpr int kMaxDelayMs = 2000;
-constexpr float kFeedbackMax = 0.95f;
-
 juce::StringArray getSyncChoices()
 {
     return { "1/1", "1/2", "1/4", "1/8", "1/16", "1/8T", "1/16T", "1/8D", "1/16D" };
 }
 
-float getDivisionMultiplier(int choiceIndex)
+juce::StringArray getFilterSlopeChoices()
 {
-    switch (choiceIndex)
-    {
-        case 0: return 1.0f;     // 1/1
-        case 1: return 0.5f;     // 1/2
-        case 2: return 0.25f;    // 1/4
-        case 3: return 0.125f;   // 1/8
-        case 4: return 0.0625f;  // 1/16
-        case 5: return 0.1666667f; // 1/8T
-        case 6: return 0.0833333f; // 1/16T
-        case 7: return 0.75f;    // 1/8D
-        case 8: return 0.375f;   // 1/16D
-        default: return 0.25f;
-    }
+    return { "12 dB/oct", "24 dB/oct" };
+}
+
+juce::StringArray getInterpolationChoices()
+{
+    return { "Linear", "Hermite", "Lagrange", "Allpass" };
+}
+
+juce::StringArray getDriveQualityChoices()
+{
+    return { "Exact", "Rational", "Table" };
+}
+
+juce::StringArray getOversamplingChoices()
+{
+    return { "Off", "2x", "4x" };
+}
+
+juce::StringArray getDelayStorageChoices()
+{
+    return { "Full", "16-bit" };
 }
 
-float applyDrive(float sample, float driveAmount)
+juce::StringArray getTimeScaleChoices()
 {
-    const float driven = sample * driveAmount;
-    return std::tanh(driven);
+    return { "x1", "x2", "x4", "x8", "x15" };
+}
+
+static_assert(EchoByHdbAudioProcessor::kMaxTimeParameterMs
+                      * EchoByHdbAudioProcessor::kTimeScales[EchoByHdbAudioProcessor::kNumTimeScales - 1]
+                  == static_cast<float>(echo::EchoEngine::kMaxDelayMs),
+              "the largest Time Scale should reach the longest delay");
+
+juce::StringArray getNumTapsChoices()
+{
+    juce::StringArray choices;
+
+    for (int count = 1; count <= echo::kMaxTaps; ++count)
+        choices.add(juce::String(count) + (count == 1 ? " Tap" : " Taps"));
+
+    return choices;
+}
+
+/** Ping-pong for a speaker layout: repeats bounce between mirrored
+    left/right speakers, while centre, LFE and other unpaired channels keep
+    their own. Layouts without any pair (discrete, ambisonics) circle
+    through all channels instead.
+*/
+echo::PingPongRouting makePingPongRouting(const juce::AudioChannelSet& layout)
+{
+    using Type = juce::AudioChannelSet::ChannelType;
+
+    constexpr Type mirroredPairs[][2] = {
+        { juce::AudioChannelSet::left, juce::AudioChannelSet::right },
+        { juce::AudioChannelSet::leftCentre, juce::AudioChannelSet::rightCentre },
+        { juce::AudioChannelSet::leftSurround, juce::AudioChannelSet::rightSurround },
+        { juce::AudioChannelSet::leftSurroundSide, juce::AudioChannelSet::rightSurroundSide },
+        { juce::AudioChannelSet::leftSurroundRear, juce::AudioChannelSet::rightSurroundRear },
+        { juce::AudioChannelSet::wideLeft, juce::AudioChannelSet::wideRight },
+        { juce::AudioChannelSet::topFrontLeft, juce::AudioChannelSet::topFrontRight },
+        { juce::AudioChannelSet::topSideLeft, juce::AudioChannelSet::topSideRight },
+        { juce::AudioChannelSet::topRearLeft, juce::AudioChannelSet::topRearRight }
+    };
+
+    echo::PingPongRouting routing;
+    const int numChannels = juce::jmin(layout.size(), echo::kMaxChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const Type type = layout.getTypeOfChannel(channel);
+        int partner = channel;
+
+        for (const auto& pair : mirroredPairs)
+        {
+            if (type != pair[0] && type != pair[1])
+                continue;
+
+            const int index = layout.getChannelIndexForType(type == pair[0] ? pair[1] : pair[0]);
+
+            if (index >= 0 && index < numChannels)
+                partner = index;
+
+            break;
+        }
+
+        routing.useMatrix = routing.useMatrix || partner != channel;
+        routing.matrix[channel][partner] = 1.0f;
+    }
+
+    return routing;
 }
 }
 
@@ -41,6 +109,59 @@ EchoByHdbAudioProcessor::EchoByHdbAudioProcessor()
                                          .withOutput("Output", juce::AudioChannelSet::stereo(), true))
     , apvts(*this, nullptr, "Parameters", createParameterLayout())
 {
+    rawParameters.timeMs = apvts.getRawParameterValue(ParameterIDs::timeMs);
+    rawParameters.sync = apvts.getRawParameterValue(ParameterIDs::sync);
+    rawParameters.syncDivision = apvts.getRawParameterValue(ParameterIDs::syncDivision);
+    rawParameters.feedback = apvts.getRawParameterValue(ParameterIDs::feedback);
+    rawParameters.mix = apvts.getRawParameterValue(ParameterIDs::mix);
+    rawParameters.lowCut = apvts.getRawParameterValue(ParameterIDs::lowCut);
+    rawParameters.highCut = apvts.getRawParameterValue(ParameterIDs::highCut);
+    rawParameters.filterSlope = apvts.getRawParameterValue(ParameterIDs::filterSlope);
+    rawParameters.pingPong = apvts.getRawParameterValue(ParameterIDs::pingPong);
+    rawParameters.interpolation = apvts.getRawParameterValue(ParameterIDs::interpolation);
+    rawParameters.drive = apvts.getRawParameterValue(ParameterIDs::drive);
+    rawParameters.driveQuality = apvts.getRawParameterValue(ParameterIDs::driveQuality);
+    rawParameters.oversampling = apvts.getRawParameterValue(ParameterIDs::oversampling);
+    rawParameters.output = apvts.getRawParameterValue(ParameterIDs::output);
+    rawParameters.delayStorage = apvts.getRawParameterValue(ParameterIDs::delayStorage);
+    rawParameters.numTaps = apvts.getRawParameterValue(ParameterIDs::numTaps);
+    rawParameters.modDepth = apvts.getRawParameterValue(ParameterIDs::modDepth);
+    rawParameters.modRate = apvts.getRawParameterValue(ParameterIDs::modRate);
+    rawParameters.modSync = apvts.getRawParameterValue(ParameterIDs::modSync);
+    rawParameters.modDivision = apvts.getRawParameterValue(ParameterIDs::modDivision);
+    rawParameters.modDrift = apvts.getRawParameterValue(ParameterIDs::modDrift);
+    rawParameters.modSpread = apvts.getRawParameterValue(ParameterIDs::modSpread);
+    rawParameters.diffusion = apvts.getRawParameterValue(ParameterIDs::diffusion);
+    rawParameters.diffusionSize = apvts.getRawParameterValue(ParameterIDs::diffusionSize);
+    rawParameters.timeScale = apvts.getRawParameterValue(ParameterIDs::timeScale);
+
+    for (int tap = 0; tap < echo::kMaxTaps; ++tap)
+    {
+        auto& rawTap = rawParameters.taps[tap];
+
+        if (tap > 0)
+        {
+            rawTap.time = apvts.getRawParameterValue(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapTimeSuffix));
+            rawTap.division = apvts.getRawParameterValue(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapDivisionSuffix));
+        }
+
+        rawTap.gain = apvts.getRawParameterValue(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapGainSuffix));
+        rawTap.pan = apvts.getRawParameterValue(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapPanSuffix));
+        rawTap.send = apvts.getRawParameterValue(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapSendSuffix));
+    }
+
+    startTimerHz(10);
+}
+
+EchoByHdbAudioProcessor::~EchoByHdbAudioProcessor()
+{
+    stopTimer();
+}
+
+void EchoByHdbAudioProcessor::timerCallback()
+{
+    engine.updateDelayLine();
+    doubleEngine.updateDelayLine();
 }
 
 const juce::String EchoByHdbAudioProcessor::getName() const
@@ -65,7 +186,7 @@ bool EchoByHdbAudioProcessor::isMidiEffect() const
 
 double EchoByHdbAudioProcessor::getTailLengthSeconds() const
 {
-    return 2.5;
+    return echo::EchoEngine::getTailLengthSeconds(makeParameterSnapshot(lastHostBpm.load()));
 }
 
 int EchoByHdbAudioProcessor::getNumPrograms()
@@ -96,34 +217,36 @@ void EchoByHdbAudioProcessor::changeProgramName(int index, const juce::String& n
 
 void EchoByHdbAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    maxDelaySamples = static_cast<int>(std::ceil(sampleRate * (kMaxDelayMs / 1000.0))) + samplesPerBlock;
-    delayBuffer.setSize(getTotalNumOutputChannels(), maxDelaySamples);
-    delayBuffer.clear();
-    writePosition = 0;
-
-    const auto smoothTime = 0.05;
-    timeSmoothed.reset(sampleRate, smoothTime);
-    feedbackSmoothed.reset(sampleRate, smoothTime);
-    mixSmoothed.reset(sampleRate, smoothTime);
-    outputSmoothed.reset(sampleRate, smoothTime);
-
-    timeSmoothed.setCurrentAndTargetValue(apvts.getRawParameterValue(ParameterIDs::timeMs)->load());
-    feedbackSmoothed.setCurrentAndTargetValue(apvts.getRawParameterValue(ParameterIDs::feedback)->load() / 100.0f);
-    mixSmoothed.setCurrentAndTargetValue(apvts.getRawParameterValue(ParameterIDs::mix)->load() / 100.0f);
-    outputSmoothed.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(
-        apvts.getRawParameterValue(ParameterIDs::output)->load()));
-
-    updateFilters();
+    // The host sets the processing precision before preparing.
+    if (isUsingDoublePrecision())
+        prepareEngine(doubleEngine, sampleRate, samplesPerBlock);
+    else
+        prepareEngine(engine, sampleRate, samplesPerBlock);
+}
 
-    for (auto& filter : lowCutFilters)
-        filter.reset();
-    for (auto& filter : highCutFilters)
-        filter.reset();
+template <typename Sample>
+void EchoByHdbAudioProcessor::prepareEngine(echo::BasicEchoEngine<Sample>& engineToPrepare, double sampleRate,
+                                            int samplesPerBlock)
+{
+    pingPongRouting = makePingPongRouting(getChannelLayoutOfBus(false, 0));
+    engineToPrepare.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
+
+    // Synced delays are sized from the tempo, so take it from the play head
+    // now rather than growing the line after the first block; offline
+    // renders never run the timer that would grow it.
+    const double bpm = getPlayHeadBpm();
+    engineToPrepare.reset(makeParameterSnapshot(bpm > 0.0 ? bpm : lastHostBpm.load()));
+    engineToPrepare.updateDelayLine();
+    setLatencySamples(engineToPrepare.getLatencySamples());
 }
 
 void EchoByHdbAudioProcessor::releaseResources()
 {
-    delayBuffer.setSize(0, 0);
+    engine.release();
+    doubleEngine.release();
+
+    if constexpr (echo::RealtimeMonitor::kEnabled)
+        DBG("Realtime guard: " << realtimeMonitor.formatReport());
 }
 
 bool EchoByHdbAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
@@ -131,137 +254,107 @@ bool EchoByHdbAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts)
     const auto& inputLayout = layouts.getMainInputChannelSet();
     const auto& outputLayout = layouts.getMainOutputChannelSet();
 
-    if (outputLayout != juce::AudioChannelSet::stereo())
+    // Any layout the engine has channels for; the input either matches it
+    // or is mono, which feeds every channel.
+    if (outputLayout.isDisabled() || outputLayout.size() > echo::kMaxChannels)
         return false;
 
-    if (inputLayout != juce::AudioChannelSet::stereo() && inputLayout != juce::AudioChannelSet::mono())
-        return false;
-
-    return true;
+    return inputLayout == outputLayout || inputLayout == juce::AudioChannelSet::mono();
 }
 
-float EchoByHdbAudioProcessor::getSyncTimeSeconds(double bpm) const
+double EchoByHdbAudioProcessor::getPlayHeadBpm()
 {
-    const auto divisionIndex = static_cast<int>(apvts.getRawParameterValue(ParameterIDs::syncDivision)->load());
-    const float multiplier = getDivisionMultiplier(divisionIndex);
-    const double quarterNoteSeconds = 60.0 / bpm;
-    return static_cast<float>(quarterNoteSeconds * 4.0 * multiplier);
+    if (auto* playHead = getPlayHead())
+    {
+        if (playHead->getCurrentPosition(positionInfo) && positionInfo.bpm > 0.0)
+            return positionInfo.bpm;
+    }
+
+    return 0.0;
 }
 
-void EchoByHdbAudioProcessor::updateFilters()
+echo::EchoParameters EchoByHdbAudioProcessor::makeParameterSnapshot(double bpm) const
 {
-    const auto sampleRate = getSampleRate();
-    const auto lowCutHz = apvts.getRawParameterValue(ParameterIDs::lowCut)->load();
-    const auto highCutHz = apvts.getRawParameterValue(ParameterIDs::highCut)->load();
+    const float timeScale = getTimeScale(static_cast<int>(rawParameters.timeScale->load()));
+
+    echo::EchoParameters params;
+    params.timeMs = rawParameters.timeMs->load() * timeScale;
+    params.syncEnabled = rawParameters.sync->load() > 0.5f;
+    params.syncDivision = static_cast<int>(rawParameters.syncDivision->load());
+    params.hostBpm = bpm;
+    params.feedback = rawParameters.feedback->load() / 100.0f;
+    params.mix = rawParameters.mix->load() / 100.0f;
+    params.lowCutHz = rawParameters.lowCut->load();
+    params.highCutHz = rawParameters.highCut->load();
+    params.filterSlope = static_cast<echo::FilterSlope>(juce::jlimit(0, echo::kNumFilterSlopes - 1,
+        static_cast<int>(rawParameters.filterSlope->load())));
+    params.pingPong = rawParameters.pingPong->load() > 0.5f;
+    params.pingPongRouting = pingPongRouting;
+    params.interpolation = static_cast<echo::Interpolation>(juce::jlimit(0, echo::kNumInterpolations - 1,
+        static_cast<int>(rawParameters.interpolation->load())));
+    params.driveDb = rawParameters.drive->load();
+    params.driveQuality = static_cast<echo::DriveQuality>(juce::jlimit(0, echo::kNumDriveQualities - 1,
+        static_cast<int>(rawParameters.driveQuality->load())));
+    params.oversampling = static_cast<echo::Oversampling>(juce::jlimit(0, echo::kNumOversamplingModes - 1,
+        static_cast<int>(rawParameters.oversampling->load())));
+    params.outputDb = rawParameters.output->load();
+    params.delayStorage = static_cast<echo::DelayStorage>(juce::jlimit(0, echo::kNumDelayStorages - 1,
+        static_cast<int>(rawParameters.delayStorage->load())));
+    params.numTaps = static_cast<int>(rawParameters.numTaps->load()) + 1;
+    params.modulation.depthMs = rawParameters.modDepth->load();
+    params.modulation.rateHz = rawParameters.modRate->load();
+    params.modulation.syncEnabled = rawParameters.modSync->load() > 0.5f;
+    params.modulation.syncDivision = static_cast<int>(rawParameters.modDivision->load());
+    params.modulation.drift = rawParameters.modDrift->load() / 100.0f;
+    params.modulation.spread = rawParameters.modSpread->load() / 100.0f;
+    params.diffusion.amount = rawParameters.diffusion->load() / 100.0f;
+    params.diffusion.size = rawParameters.diffusionSize->load() / 100.0f;
+
+    for (int tap = 0; tap < echo::kMaxTaps; ++tap)
+    {
+        const auto& rawTap = rawParameters.taps[tap];
+        auto& tapParams = params.taps[tap];
+
+        if (tap > 0)
+        {
+            tapParams.timeMs = rawTap.time->load() * timeScale;
+            tapParams.syncDivision = static_cast<int>(rawTap.division->load());
+        }
 
-    const auto lowCutCoeffs = juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, lowCutHz);
-    const auto highCutCoeffs = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, highCutHz);
+        tapParams.gain = rawTap.gain->load() / 100.0f;
+        tapParams.pan = rawTap.pan->load() / 100.0f;
+        tapParams.feedbackSend = rawTap.send->load() / 100.0f;
+    }
 
-    for (auto& filter : lowCutFilters)
-        filter.state = lowCutCoeffs;
-    for (auto& filter : highCutFilters)
-        filter.state = highCutCoeffs;
+    return params;
 }
 
 void EchoByHdbAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused(midiMessages);
-    juce::ScopedNoDenormals noDenormals;
-
-    const int numSamples = buffer.getNumSamples();
-    const int numChannels = buffer.getNumChannels();
-
-    const bool syncEnabled = apvts.getRawParameterValue(ParameterIDs::sync)->load() > 0.5f;
-    const float timeMs = apvts.getRawParameterValue(ParameterIDs::timeMs)->load();
-    const float feedbackPercent = apvts.getRawParameterValue(ParameterIDs::feedback)->load();
-    const float mixPercent = apvts.getRawParameterValue(ParameterIDs::mix)->load();
-    const float driveDb = apvts.getRawParameterValue(ParameterIDs::drive)->load();
-    const float outputDb = apvts.getRawParameterValue(ParameterIDs::output)->load();
-    const bool pingPongEnabled = apvts.getRawParameterValue(ParameterIDs::pingPong)->load() > 0.5f;
-
-    const float feedbackValue = juce::jlimit(0.0f, kFeedbackMax, feedbackPercent / 100.0f);
-    const float mixValue = juce::jlimit(0.0f, 1.0f, mixPercent / 100.0f);
+    processWithEngine(engine, buffer);
+}
 
-    timeSmoothed.setTargetValue(timeMs);
-    feedbackSmoothed.setTargetValue(feedbackValue);
-    mixSmoothed.setTargetValue(mixValue);
-    outputSmoothed.setTargetValue(juce::Decibels::decibelsToGain(outputDb));
+void EchoByHdbAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processWithEngine(doubleEngine, buffer);
+}
 
-    updateFilters();
+template <typename Sample>
+void EchoByHdbAudioProcessor::processWithEngine(echo::BasicEchoEngine<Sample>& engineToUse,
+                                                juce::AudioBuffer<Sample>& buffer)
+{
+    const echo::RealtimeMonitor::BlockScope realtimeScope(realtimeMonitor, buffer.getNumSamples(), getSampleRate());
 
     double bpm = 0.0;
-    if (syncEnabled)
-    {
-        if (auto* playHead = getPlayHead())
-        {
-            if (playHead->getCurrentPosition(positionInfo) && positionInfo.bpm > 0.0)
-                bpm = positionInfo.bpm;
-        }
-    }
+    if (rawParameters.sync->load() > 0.5f || rawParameters.modSync->load() > 0.5f)
+        bpm = getPlayHeadBpm();
 
-    const float driveGain = juce::Decibels::decibelsToGain(driveDb);
+    lastHostBpm.store(bpm);
 
-    for (int sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex)
-    {
-        const float targetDelayMs = syncEnabled && bpm > 0.0
-            ? getSyncTimeSeconds(bpm) * 1000.0f
-            : timeSmoothed.getNextValue();
-
-        const float delaySamples = juce::jlimit(1.0f, static_cast<float>(maxDelaySamples - 1),
-            (targetDelayMs / 1000.0f) * static_cast<float>(getSampleRate()));
-
-        const int delaySamplesInt = static_cast<int>(delaySamples);
-        const float frac = delaySamples - static_cast<float>(delaySamplesInt);
-
-        const int readIndexA = (writePosition - delaySamplesInt + maxDelaySamples) % maxDelaySamples;
-        const int readIndexB = (readIndexA - 1 + maxDelaySamples) % maxDelaySamples;
-
-        float delayedSamples[2]{};
-
-        for (int channel = 0; channel < numChannels; ++channel)
-        {
-            const float sampleA = delayBuffer.getSample(channel, readIndexA);
-            const float sampleB = delayBuffer.getSample(channel, readIndexB);
-            delayedSamples[channel] = juce::jmap(frac, sampleA, sampleB);
-        }
-
-        const float feedbackAmount = feedbackSmoothed.getNextValue();
-        const float mix = mixSmoothed.getNextValue();
-        const float outputGain = outputSmoothed.getNextValue();
-
-        float feedbackSamples[2]{};
-        if (pingPongEnabled)
-        {
-            feedbackSamples[0] = delayedSamples[1];
-            feedbackSamples[1] = delayedSamples[0];
-        }
-        else
-        {
-            feedbackSamples[0] = delayedSamples[0];
-            feedbackSamples[1] = delayedSamples[1];
-        }
-
-        for (int channel = 0; channel < numChannels; ++channel)
-        {
-            const float inputSample = buffer.getSample(channel, sampleIndex);
-            float filtered = lowCutFilters[channel].processSample(feedbackSamples[channel]);
-            filtered = highCutFilters[channel].processSample(filtered);
-            filtered = applyDrive(filtered, driveGain);
-
-            const float feedbackSample = filtered * feedbackAmount;
-            const float writeSample = inputSample + feedbackSample;
-            delayBuffer.setSample(channel, writePosition, writeSample);
-
-            const float dryGain = std::cos(mix * juce::MathConstants<float>::halfPi);
-            const float wetGain = std::sin(mix * juce::MathConstants<float>::halfPi);
-
-            const float outputSample = (inputSample * dryGain) + (delayedSamples[channel] * wetGain);
-            buffer.setSample(channel, sampleIndex, outputSample * outputGain);
-        }
-
-        if (++writePosition >= maxDelaySamples)
-            writePosition = 0;
-    }
+    engineToUse.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), getTotalNumInputChannels(),
+                        buffer.getNumSamples(), makeParameterSnapshot(bpm));
 }
 
 bool EchoByHdbAudioProcessor::hasEditor() const
@@ -276,21 +369,12 @@ juce::AudioProcessorEditor* EchoByHdbAudioProcessor::createEditor()
 
 void EchoByHdbAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    if (auto state = apvts.copyState(); state.isValid())
-    {
-        std::unique_ptr<juce::XmlElement> xml(state.createXml());
-        copyXmlToBinary(*xml, destData);
-    }
+    stateFormat.write(destData);
 }
 
 void EchoByHdbAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
-    if (xmlState != nullptr)
-    {
-        if (xmlState->hasTagName(apvts.state.getType()))
-            apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
-    }
+    stateFormat.read(data, sizeInBytes);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout EchoByHdbAudioProcessor::createParameterLayout()
@@ -300,7 +384,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout EchoByHdbAudioProcessor::cre
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         ParameterIDs::timeMs,
         "Time",
-        juce::NormalisableRange<float>(1.0f, 2000.0f, 0.01f, 0.5f),
+        juce::NormalisableRange<float>(1.0f, kMaxTimeParameterMs, 0.01f, 0.5f),
         400.0f,
         "ms"));
 
@@ -343,11 +427,23 @@ juce::AudioProcessorValueTreeState::ParameterLayout EchoByHdbAudioProcessor::cre
         8000.0f,
         "Hz"));
 
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::filterSlope,
+        "Filter Slope",
+        getFilterSlopeChoices(),
+        0));
+
     layout.add(std::make_unique<juce::AudioParameterBool>(
         ParameterIDs::pingPong,
         "PingPong",
         false));
 
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::interpolation,
+        "Interpolation",
+        getInterpolationChoices(),
+        0));
+
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         ParameterIDs::drive,
         "Drive",
@@ -355,6 +451,18 @@ juce::AudioProcessorValueTreeState::ParameterLayout EchoByHdbAudioProcessor::cre
         6.0f,
         "dB"));
 
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::driveQuality,
+        "Drive Quality",
+        getDriveQualityChoices(),
+        static_cast<int>(echo::kDefaultDriveQuality)));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::oversampling,
+        "Oversampling",
+        getOversamplingChoices(),
+        0));
+
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         ParameterIDs::output,
         "Output",
@@ -362,5 +470,120 @@ juce::AudioProcessorValueTreeState::ParameterLayout EchoByHdbAudioProcessor::cre
         0.0f,
         "dB"));
 
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::delayStorage,
+        "Delay Precision",
+        getDelayStorageChoices(),
+        0));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::numTaps,
+        "Taps",
+        getNumTapsChoices(),
+        0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParameterIDs::modDepth,
+        "Mod Depth",
+        juce::NormalisableRange<float>(0.0f, echo::modulation::kMaxDepthMs, 0.01f, 0.5f),
+        0.0f,
+        "ms"));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParameterIDs::modRate,
+        "Mod Rate",
+        juce::NormalisableRange<float>(0.05f, 10.0f, 0.01f, 0.4f),
+        0.5f,
+        "Hz"));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        ParameterIDs::modSync,
+        "Mod Sync",
+        false));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::modDivision,
+        "Mod Division",
+        getSyncChoices(),
+        0));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParameterIDs::modDrift,
+        "Mod Drift",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f),
+        0.0f,
+        "%"));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParameterIDs::modSpread,
+        "Mod Spread",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f),
+        50.0f,
+        "%"));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParameterIDs::diffusion,
+        "Diffusion",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f),
+        0.0f,
+        "%"));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        ParameterIDs::diffusionSize,
+        "Diffusion Size",
+        juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f),
+        50.0f,
+        "%"));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        ParameterIDs::timeScale,
+        "Time Scale",
+        getTimeScaleChoices(),
+        0));
+
+    // Extra taps default to a spread pattern trailing the first tap: later,
+    // quieter, alternating sides and kept out of the feedback loop.
+    for (int tap = 0; tap < echo::kMaxTaps; ++tap)
+    {
+        const juce::String name = "Tap " + juce::String(tap + 1) + " ";
+
+        if (tap > 0)
+        {
+            layout.add(std::make_unique<juce::AudioParameterFloat>(
+                ParameterIDs::getTapParameterID(tap, ParameterIDs::tapTimeSuffix),
+                name + "Time",
+                juce::NormalisableRange<float>(1.0f, kMaxTimeParameterMs, 0.01f, 0.5f),
+                400.0f + 200.0f * static_cast<float>(tap),
+                "ms"));
+
+            layout.add(std::make_unique<juce::AudioParameterChoice>(
+                ParameterIDs::getTapParameterID(tap, ParameterIDs::tapDivisionSuffix),
+                name + "Division",
+                getSyncChoices(),
+                2));
+        }
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            ParameterIDs::getTapParameterID(tap, ParameterIDs::tapGainSuffix),
+            name + "Gain",
+            juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f),
+            100.0f / static_cast<float>(tap + 1),
+            "%"));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            ParameterIDs::getTapParameterID(tap, ParameterIDs::tapPanSuffix),
+            name + "Pan",
+            juce::NormalisableRange<float>(-100.0f, 100.0f, 0.01f),
+            tap == 0 ? 0.0f : (tap % 2 == 1 ? -50.0f : 50.0f),
+            "%"));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            ParameterIDs::getTapParameterID(tap, ParameterIDs::tapSendSuffix),
+            name + "Send",
+            juce::NormalisableRange<float>(0.0f, 100.0f, 0.01f),
+            tap == 0 ? 100.0f : 0.0f,
+            "%"));
+    }
+
     return layout;
 }
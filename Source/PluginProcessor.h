@@ -1,18 +1,28 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "Engine/EchoEngine.h"
+#include "Engine/RealtimeMonitor.h"
+#include "StateFormat.h"
 
-class EchoByHdbAudioProcessor final : public juce::AudioProcessor
+class EchoByHdbAudioProcessor final : public juce::AudioProcessor,
+                                      private juce::Timer
 {
 public:
     EchoByHdbAudioProcessor();
-    ~EchoByHdbAudioProcessor() override = default;
+    ~EchoByHdbAudioProcessor() override;
 
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
     bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
+    /** Double-precision hosts get their own engine instance running the
+        double instantiation of the DSP, so nothing is converted to float.
+    */
+    bool supportsDoublePrecisionProcessing() const override { return true; }
+
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -34,28 +44,126 @@ public:
 
     juce::AudioProcessorValueTreeState& getAPVTS() { return apvts; }
 
+    /** The Time and tap time parameters keep the 1 to 2000 ms range that
+        sessions and automation were saved against; Time Scale multiplies
+        them, up to the engine's longest delay.
+    */
+    static constexpr float kMaxTimeParameterMs = 2000.0f;
+    static constexpr float kTimeScales[] = { 1.0f, 2.0f, 4.0f, 8.0f, 15.0f };
+    static constexpr int kNumTimeScales = 5;
+
+    static float getTimeScale(int index) noexcept
+    {
+        return kTimeScales[juce::jlimit(0, kNumTimeScales - 1, index)];
+    }
+
+    /** Audio-thread statistics; only collected in ECHO_RT_GUARD builds. */
+    const echo::RealtimeMonitor& getRealtimeMonitor() const noexcept { return realtimeMonitor; }
+
+    /** Engine metering; the editor switches it on while it's open and polls
+        the snapshots from its timer.
+    */
+    void setMeteringActive(bool shouldMeter) noexcept
+    {
+        engine.setMeteringEnabled(shouldMeter);
+        doubleEngine.setMeteringEnabled(shouldMeter);
+    }
+
+    const echo::MeterSnapshot* pollMeters() noexcept
+    {
+        return isUsingDoublePrecision() ? doubleEngine.pollMeters() : engine.pollMeters();
+    }
+
+    /** True once the last block had nothing audible left in the delay line;
+        offline renders stop the tail there.
+    */
+    bool isAsleep() const noexcept
+    {
+        return isUsingDoublePrecision() ? doubleEngine.isAsleep() : engine.isAsleep();
+    }
+
 private:
     juce::AudioProcessorValueTreeState apvts;
 
-    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-
-    float getSyncTimeSeconds(double bpm) const;
+    // Saves and loads the parameters as a fixed binary layout, without the
+    // XML and ValueTree round trip.
+    StateFormat stateFormat { apvts };
 
-    void updateFilters();
-
-    juce::AudioBuffer<float> delayBuffer;
-    int writePosition = 0;
-    int maxDelaySamples = 1;
-
-    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> timeSmoothed;
-    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> feedbackSmoothed;
-    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> mixSmoothed;
-    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> outputSmoothed;
+    juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
-    juce::dsp::IIR::Filter<float> lowCutFilters[2];
-    juce::dsp::IIR::Filter<float> highCutFilters[2];
+    echo::EchoParameters makeParameterSnapshot(double bpm) const;
+
+    /** The play head's tempo, or 0 if there is no play head or it has none. */
+    double getPlayHeadBpm();
+
+    template <typename Sample>
+    void prepareEngine(echo::BasicEchoEngine<Sample>& engineToPrepare, double sampleRate, int samplesPerBlock);
+
+    template <typename Sample>
+    void processWithEngine(echo::BasicEchoEngine<Sample>& engineToUse, juce::AudioBuffer<Sample>& buffer);
+
+    // Grows the engine's delay line off the audio thread when a longer
+    // delay or another storage format is asked for.
+    void timerCallback() override;
+
+    // Looked up once in the constructor so processBlock doesn't search the
+    // parameter tree for every value.
+    struct RawParameters
+    {
+        std::atomic<float>* timeMs = nullptr;
+        std::atomic<float>* sync = nullptr;
+        std::atomic<float>* syncDivision = nullptr;
+        std::atomic<float>* feedback = nullptr;
+        std::atomic<float>* mix = nullptr;
+        std::atomic<float>* lowCut = nullptr;
+        std::atomic<float>* highCut = nullptr;
+        std::atomic<float>* filterSlope = nullptr;
+        std::atomic<float>* pingPong = nullptr;
+        std::atomic<float>* interpolation = nullptr;
+        std::atomic<float>* drive = nullptr;
+        std::atomic<float>* driveQuality = nullptr;
+        std::atomic<float>* oversampling = nullptr;
+        std::atomic<float>* output = nullptr;
+        std::atomic<float>* delayStorage = nullptr;
+        std::atomic<float>* numTaps = nullptr;
+        std::atomic<float>* modDepth = nullptr;
+        std::atomic<float>* modRate = nullptr;
+        std::atomic<float>* modSync = nullptr;
+        std::atomic<float>* modDivision = nullptr;
+        std::atomic<float>* modDrift = nullptr;
+        std::atomic<float>* modSpread = nullptr;
+        std::atomic<float>* diffusion = nullptr;
+        std::atomic<float>* diffusionSize = nullptr;
+        std::atomic<float>* timeScale = nullptr;
+
+        // time and division stay null for the first tap, which uses the main ones.
+        struct Tap
+        {
+            std::atomic<float>* time = nullptr;
+            std::atomic<float>* division = nullptr;
+            std::atomic<float>* gain = nullptr;
+            std::atomic<float>* pan = nullptr;
+            std::atomic<float>* send = nullptr;
+        };
+
+        Tap taps[echo::kMaxTaps];
+    };
+
+    RawParameters rawParameters;
+
+    // One engine per processing precision. Only the one the host uses is
+    // prepared, so the other never allocates a delay line.
+    echo::EchoEngine engine;
+    echo::EchoEngineDouble doubleEngine;
+    echo::RealtimeMonitor realtimeMonitor;
+
+    // Ping-pong for the output layout, set up in prepareToPlay().
+    echo::PingPongRouting pingPongRouting;
 
     juce::AudioPlayHead::CurrentPositionInfo positionInfo;
 
+    // The tempo the last block was synced to, for getTailLengthSeconds().
+    std::atomic<double> lastHostBpm { 0.0 };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EchoByHdbAudioProcessor)
 };
@@ -0,0 +1,238 @@
+#include "StateFormat.h"
+#include "ParameterIDs.h"
+#include "PluginProcessor.h"
+#include "Engine/EchoEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+StateFormat::StateFormat(juce::AudioProcessorValueTreeState& stateToUse)
+    : apvts(stateToUse)
+{
+    for (const auto& id : getParameterOrder())
+    {
+        auto* parameter = apvts.getParameter(id);
+        jassert(parameter != nullptr);
+        parameters.push_back(parameter);
+    }
+}
+
+juce::StringArray StateFormat::getParameterOrder()
+{
+    // Version 1. Append only; see the class description.
+    juce::StringArray order {
+        ParameterIDs::timeMs,
+        ParameterIDs::sync,
+        ParameterIDs::syncDivision,
+        ParameterIDs::feedback,
+        ParameterIDs::mix,
+        ParameterIDs::lowCut,
+        ParameterIDs::highCut,
+        ParameterIDs::filterSlope,
+        ParameterIDs::pingPong,
+        ParameterIDs::interpolation,
+        ParameterIDs::drive,
+        ParameterIDs::driveQuality,
+        ParameterIDs::oversampling,
+        ParameterIDs::output,
+        ParameterIDs::delayStorage,
+        ParameterIDs::numTaps,
+        ParameterIDs::modDepth,
+        ParameterIDs::modRate,
+        ParameterIDs::modSync,
+        ParameterIDs::modDivision,
+        ParameterIDs::modDrift,
+        ParameterIDs::modSpread
+    };
+
+    for (int tap = 0; tap < echo::kMaxTaps; ++tap)
+    {
+        if (tap > 0)
+        {
+            order.add(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapTimeSuffix));
+            order.add(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapDivisionSuffix));
+        }
+
+        order.add(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapGainSuffix));
+        order.add(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapPanSuffix));
+        order.add(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapSendSuffix));
+    }
+
+    // Version 2.
+    order.add(ParameterIDs::diffusion);
+    order.add(ParameterIDs::diffusionSize);
+
+    // Version 3.
+    order.add(ParameterIDs::timeScale);
+
+    return order;
+}
+
+void StateFormat::write(juce::MemoryBlock& destination) const
+{
+    const int numValues = static_cast<int>(parameters.size());
+    destination.setSize(static_cast<size_t>(kHeaderBytes + 4 * numValues));
+    auto* bytes = static_cast<juce::uint8*>(destination.getData());
+
+    juce::ByteOrder::writeLittleEndianInt(kMagic, bytes);
+    juce::ByteOrder::writeLittleEndianShort(static_cast<juce::uint16>(kVersion), bytes + 4);
+    juce::ByteOrder::writeLittleEndianShort(static_cast<juce::uint16>(numValues), bytes + 6);
+    bytes += kHeaderBytes;
+
+    for (const auto* parameter : parameters)
+    {
+        const float value = parameter->convertFrom0to1(parameter->getValue());
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        juce::ByteOrder::writeLittleEndianInt(bits, bytes);
+        bytes += 4;
+    }
+}
+
+bool StateFormat::read(const void* data, int sizeInBytes) const
+{
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+
+    if (sizeInBytes >= kHeaderBytes && juce::ByteOrder::littleEndianInt(bytes) == kMagic)
+        return readBinary(bytes, sizeInBytes);
+
+    if (const auto xml = juce::AudioProcessor::getXmlFromBinary(data, sizeInBytes))
+        return readXml(*xml);
+
+    return false;
+}
+
+bool StateFormat::readBinary(const juce::uint8* data, int sizeInBytes) const
+{
+    const int version = juce::ByteOrder::littleEndianShort(data + 4);
+    const int numStored = juce::ByteOrder::littleEndianShort(data + 6);
+
+    if (version < 1 || sizeInBytes < kHeaderBytes + 4 * numStored)
+        return false;
+
+    // Values the blob doesn't have start from their defaults, so migrate()
+    // sees a complete set.
+    std::vector<float> values(parameters.size());
+    const int numKnown = juce::jmin(numStored, static_cast<int>(parameters.size()));
+
+    for (size_t index = 0; index < parameters.size(); ++index)
+    {
+        const auto* parameter = parameters[index];
+        values[index] = parameter->convertFrom0to1(parameter->getDefaultValue());
+    }
+
+    for (int index = 0; index < numKnown; ++index)
+    {
+        const juce::uint32 bits = juce::ByteOrder::littleEndianInt(data + kHeaderBytes + 4 * index);
+        std::memcpy(&values[static_cast<size_t>(index)], &bits, sizeof(float));
+    }
+
+    if (version < kVersion)
+        migrate(version, values);
+
+    for (size_t index = 0; index < parameters.size(); ++index)
+        setPlainValue(*parameters[index], values[index]);
+
+    return true;
+}
+
+bool StateFormat::readXml(const juce::XmlElement& xml) const
+{
+    if (! xml.hasTagName(apvts.state.getType()))
+        return false;
+
+    // Matches replaceState(): parameters without an element go back to
+    // their defaults.
+    std::vector<float> values(parameters.size());
+
+    for (size_t index = 0; index < parameters.size(); ++index)
+        values[index] = parameters[index]->convertFrom0to1(parameters[index]->getDefaultValue());
+
+    bool hasTimeScale = false;
+    bool hasLongTime = false;
+
+    for (const auto* element : xml.getChildWithTagNameIterator("PARAM"))
+    {
+        const auto id = element->getStringAttribute("id");
+        const auto position = std::find(parameters.begin(), parameters.end(), apvts.getParameter(id));
+
+        if (position == parameters.end() || ! element->hasAttribute("value"))
+            continue;
+
+        const auto value = static_cast<float>(element->getDoubleAttribute("value"));
+        values[static_cast<size_t>(position - parameters.begin())] = value;
+        hasTimeScale = hasTimeScale || id == ParameterIDs::timeScale;
+
+        if (id == ParameterIDs::timeMs || (id.startsWith("tap") && id.endsWith(ParameterIDs::tapTimeSuffix)))
+            hasLongTime = hasLongTime || value > EchoByHdbAudioProcessor::kMaxTimeParameterMs;
+    }
+
+    // XML from before the binary versions has no Time Scale and may hold
+    // times up to 30 s. XML that has one is taken as saved, unless a time
+    // is beyond the Time range.
+    if (! hasTimeScale || hasLongTime)
+        migrate(0, values);
+
+    for (size_t index = 0; index < parameters.size(); ++index)
+        setPlainValue(*parameters[index], values[index]);
+
+    return true;
+}
+
+void StateFormat::migrate(int version, std::vector<float>& values)
+{
+    // One case per version that changed a stored value's meaning, each
+    // falling through to the next. Version 0 is the legacy XML.
+    switch (version)
+    {
+        case 0:
+        case 1:
+        case 2:
+            moveTimesIntoScale(values);
+            [[fallthrough]];
+
+        default:
+            break;
+    }
+}
+
+void StateFormat::moveTimesIntoScale(std::vector<float>& values)
+{
+    // Up to version 2 the Time and tap time parameters went up to 30 s by
+    // themselves. They now stop at kMaxTimeParameterMs, so the smallest Time
+    // Scale that fits the active taps takes up the rest.
+    using Processor = EchoByHdbAudioProcessor;
+
+    const auto order = getParameterOrder();
+    const auto valueOf = [&](const juce::String& id) -> float& { return values[static_cast<size_t>(order.indexOf(id))]; };
+
+    const float storedTaps = valueOf(ParameterIDs::numTaps);
+    const int numTaps = std::isfinite(storedTaps) ? juce::jlimit(1, echo::kMaxTaps, static_cast<int>(storedTaps) + 1) : 1;
+    float longest = valueOf(ParameterIDs::timeMs);
+
+    for (int tap = 1; tap < numTaps; ++tap)
+        longest = juce::jmax(longest, valueOf(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapTimeSuffix)));
+
+    int scale = 0;
+    while (scale < Processor::kNumTimeScales - 1 && longest > Processor::kMaxTimeParameterMs * Processor::kTimeScales[scale])
+        ++scale;
+
+    valueOf(ParameterIDs::timeScale) = static_cast<float>(scale);
+    valueOf(ParameterIDs::timeMs) /= Processor::kTimeScales[scale];
+
+    for (int tap = 1; tap < echo::kMaxTaps; ++tap)
+        valueOf(ParameterIDs::getTapParameterID(tap, ParameterIDs::tapTimeSuffix)) /= Processor::kTimeScales[scale];
+}
+
+void StateFormat::setPlainValue(juce::RangedAudioParameter& parameter, float value)
+{
+    if (! std::isfinite(value))
+        return;
+
+    const float normalised = parameter.convertTo0to1(value);
+
+    // Unchanged parameters don't notify the host or the editor.
+    if (normalised != parameter.getValue())
+        parameter.setValueNotifyingHost(normalised);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+/** The plugin's saved state: a fixed-layout binary record of every
+    parameter's plain value, written and read without building a ValueTree
+    or any XML.
+
+    Layout, little-endian:
+        uint32   kMagic
+        uint16   format version
+        uint16   number of values that follow
+        float32  each parameter's value in its own units, in getParameterOrder()
+
+    The order is append-only: a new parameter goes on the end and bumps
+    kVersion, so an older blob is a prefix of the current layout and the
+    parameters it lacks load at their defaults, while a newer blob read by
+    an older build has its unknown tail skipped. A change to what a stored
+    value means is handled in migrate().
+
+    Blobs saved by earlier builds, APVTS XML wrapped by copyXmlToBinary, are
+    still read, with the values taken from the XML elements. XML without a
+    Time Scale, or with a time beyond the Time range, is migrated as
+    version 0.
+*/
+class StateFormat
+{
+public:
+    static constexpr juce::uint32 kMagic = 0x42444845;  // "EHDB"
+    static constexpr int kVersion = 3;
+    static constexpr int kHeaderBytes = 8;
+
+    /** Resolves the stored order against the processor's parameters. */
+    explicit StateFormat(juce::AudioProcessorValueTreeState& stateToUse);
+
+    void write(juce::MemoryBlock& destination) const;
+
+    /** Applies a binary or legacy XML blob; false if it is neither. */
+    bool read(const void* data, int sizeInBytes) const;
+
+    /** Parameter IDs in stored order. */
+    static juce::StringArray getParameterOrder();
+
+private:
+    bool readBinary(const juce::uint8* data, int sizeInBytes) const;
+    bool readXml(const juce::XmlElement& xml) const;
+
+    /** Brings values stored by an older version up to the current meaning. */
+    static void migrate(int version, std::vector<float>& values);
+    static void moveTimesIntoScale(std::vector<float>& values);
+
+    static void setPlainValue(juce::RangedAudioParameter& parameter, float value);
+
+    juce::AudioProcessorValueTreeState& apvts;
+    std::vector<juce::RangedAudioParameter*> parameters;
+};
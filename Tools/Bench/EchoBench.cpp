@@ -0,0 +1,471 @@
+// Headless benchmark for the echo engine: runs a matrix of sample rates,
+// block sizes and modes and prints ns/sample and blocks/second as JSON or CSV.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Engine/EchoEngine.h"
+#include "Engine/RealtimeMonitor.h"
+
+namespace
+{
+struct BenchCase
+{
+    bool doublePrecision = false;
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    bool monoInput = false;
+    bool pingPong = false;
+    bool sync = false;
+    bool automated = false;
+    echo::Interpolation interpolation = echo::Interpolation::linear;
+};
+
+struct BenchResult
+{
+    BenchCase benchCase;
+    double nsPerSample = 0.0;
+    double blocksPerSecond = 0.0;
+    double realtimeFactor = 0.0;
+};
+
+struct Options
+{
+    bool csv = false;
+    bool quick = false;
+    bool realtimeReport = false;
+    int interpolation = -1;     // -1 runs every mode
+    int precision = -1;         // -1 runs both, 0 float, 1 double
+    int numTaps = 1;
+    int numChannels = 2;
+    double seconds = 2.0;
+    int repeats = 3;
+    echo::KernelIsa isa = echo::getBestKernelIsa();
+    echo::DriveQuality driveQuality = echo::kDefaultDriveQuality;
+    echo::Oversampling oversampling = echo::Oversampling::off;
+    echo::DelayStorage delayStorage = echo::DelayStorage::full;
+    echo::FilterSlope filterSlope = echo::FilterSlope::db12;
+    float modulationDepthMs = 0.0f;
+    float diffusion = 0.0f;
+};
+
+constexpr double kWarmupSeconds = 0.25;
+constexpr double kHostBpm = 120.0;
+
+void printUsage()
+{
+    std::printf("Usage: EchoByHDB_bench [options]\n"
+                "  --format json|csv       Output format (default json)\n"
+                "  --seconds <s>           Audio seconds processed per case (default 2)\n"
+                "  --repeats <n>           Runs per case, the median is reported (default 3)\n"
+                "  --isa scalar|sse2|avx2|neon\n"
+                "                          Kernel instruction set (default: best supported)\n"
+                "  --drive-quality exact|rational|table\n"
+                "  --oversampling off|2x|4x\n"
+                "  --storage full|half\n"
+                "                          Delay line sample format (default full)\n"
+                "  --slope 12|24           LowCut/HighCut slope in dB/oct (default 12)\n"
+                "  --modulation <ms>       Delay modulation depth, 0..20 (default 0, off)\n"
+                "  --diffusion <amount>    Feedback diffusion amount, 0..1 (default 0, off)\n"
+                "  --precision float|double\n"
+                "                          Only run this sample type (default: both)\n"
+                "  --interpolation linear|hermite|lagrange|allpass\n"
+                "                          Only run this mode (default: all)\n"
+                "  --taps <n>              Read heads per case, 1..8 (default 1)\n"
+                "  --channels <n>          Channels per case, 1..16 (default 2)\n"
+                "  --quick                 48 kHz and block sizes 64/512 only\n"
+                "  --rt-report             Print the real-time guard statistics to stderr\n"
+                "                          (needs a build with -DECHO_RT_GUARD=ON)\n");
+}
+
+const char* const interpolationNames[echo::kNumInterpolations] = { "linear", "hermite", "lagrange", "allpass" };
+
+int getInterpolationIndex(const std::string& name)
+{
+    for (int i = 0; i < echo::kNumInterpolations; ++i)
+        if (name == interpolationNames[i])
+            return i;
+
+    return -1;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : "";
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        else if (arg == "--quick")
+        {
+            options.quick = true;
+            continue;
+        }
+        else if (arg == "--rt-report")
+        {
+            options.realtimeReport = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+
+        ++i;
+        const std::string text = value;
+
+        if (arg == "--format" && (text == "json" || text == "csv"))
+            options.csv = text == "csv";
+        else if (arg == "--seconds" && std::atof(value) > 0.0)
+            options.seconds = std::atof(value);
+        else if (arg == "--repeats" && std::atoi(value) > 0)
+            options.repeats = std::atoi(value);
+        else if (arg == "--isa" && text == "scalar")
+            options.isa = echo::KernelIsa::scalar;
+        else if (arg == "--isa" && text == "sse2")
+            options.isa = echo::KernelIsa::sse2;
+        else if (arg == "--isa" && text == "avx2")
+            options.isa = echo::KernelIsa::avx2;
+        else if (arg == "--isa" && text == "neon")
+            options.isa = echo::KernelIsa::neon;
+        else if (arg == "--drive-quality" && text == "exact")
+            options.driveQuality = echo::DriveQuality::exact;
+        else if (arg == "--drive-quality" && text == "rational")
+            options.driveQuality = echo::DriveQuality::rational;
+        else if (arg == "--drive-quality" && text == "table")
+            options.driveQuality = echo::DriveQuality::table;
+        else if (arg == "--interpolation" && getInterpolationIndex(text) >= 0)
+            options.interpolation = getInterpolationIndex(text);
+        else if (arg == "--taps" && std::atoi(value) >= 1 && std::atoi(value) <= echo::kMaxTaps)
+            options.numTaps = std::atoi(value);
+        else if (arg == "--channels" && std::atoi(value) >= 1 && std::atoi(value) <= echo::kMaxChannels)
+            options.numChannels = std::atoi(value);
+        else if (arg == "--storage" && text == "full")
+            options.delayStorage = echo::DelayStorage::full;
+        else if (arg == "--storage" && text == "half")
+            options.delayStorage = echo::DelayStorage::half;
+        else if (arg == "--slope" && text == "12")
+            options.filterSlope = echo::FilterSlope::db12;
+        else if (arg == "--slope" && text == "24")
+            options.filterSlope = echo::FilterSlope::db24;
+        else if (arg == "--modulation" && std::atof(value) >= 0.0 && std::atof(value) <= echo::modulation::kMaxDepthMs)
+            options.modulationDepthMs = static_cast<float>(std::atof(value));
+        else if (arg == "--diffusion" && std::atof(value) >= 0.0 && std::atof(value) <= 1.0)
+            options.diffusion = static_cast<float>(std::atof(value));
+        else if (arg == "--precision" && (text == "float" || text == "double"))
+            options.precision = text == "double" ? 1 : 0;
+        else if (arg == "--oversampling" && text == "off")
+            options.oversampling = echo::Oversampling::off;
+        else if (arg == "--oversampling" && text == "2x")
+            options.oversampling = echo::Oversampling::x2;
+        else if (arg == "--oversampling" && text == "4x")
+            options.oversampling = echo::Oversampling::x4;
+        else
+        {
+            std::fprintf(stderr, "Invalid option: %s %s\n", arg.c_str(), value);
+            return false;
+        }
+    }
+
+    if (! echo::isKernelIsaSupported(options.isa))
+    {
+        std::fprintf(stderr, "Requested instruction set isn't supported here, using scalar\n");
+        options.isa = echo::KernelIsa::scalar;
+    }
+
+    return true;
+}
+
+std::vector<BenchCase> makeMatrix(const Options& options)
+{
+    const bool quick = options.quick;
+    const std::vector<double> sampleRates = quick ? std::vector<double> { 48000.0 }
+                                                  : std::vector<double> { 44100.0, 48000.0, 96000.0, 192000.0 };
+    const std::vector<int> blockSizes = quick ? std::vector<int> { 64, 512 }
+                                              : std::vector<int> { 16, 64, 256, 1024, 4096 };
+
+    std::vector<BenchCase> cases;
+
+    for (int precision = 0; precision < 2; ++precision)
+    {
+        if (options.precision >= 0 && precision != options.precision)
+            continue;
+
+        for (int interpolation = 0; interpolation < echo::kNumInterpolations; ++interpolation)
+        {
+            if (options.interpolation >= 0 && interpolation != options.interpolation)
+                continue;
+
+            for (double sampleRate : sampleRates)
+                for (int blockSize : blockSizes)
+                    for (int flags = 0; flags < 16; ++flags)
+                    {
+                        BenchCase benchCase;
+                        benchCase.doublePrecision = precision == 1;
+                        benchCase.interpolation = static_cast<echo::Interpolation>(interpolation);
+                        benchCase.sampleRate = sampleRate;
+                        benchCase.blockSize = blockSize;
+                        benchCase.monoInput = (flags & 1) != 0;
+                        benchCase.pingPong = (flags & 2) != 0;
+                        benchCase.sync = (flags & 4) != 0;
+                        benchCase.automated = (flags & 8) != 0;
+                        cases.push_back(benchCase);
+                    }
+        }
+    }
+
+    return cases;
+}
+
+echo::EchoParameters makeParameters(const BenchCase& benchCase, const Options& options)
+{
+    echo::EchoParameters params;
+    params.timeMs = 350.0f;
+    params.syncEnabled = benchCase.sync;
+    params.syncDivision = 3;
+    params.hostBpm = kHostBpm;
+    params.feedback = 0.6f;
+    params.pingPong = benchCase.pingPong;
+    params.interpolation = benchCase.interpolation;
+    params.driveQuality = options.driveQuality;
+    params.oversampling = options.oversampling;
+    params.delayStorage = options.delayStorage;
+    params.filterSlope = options.filterSlope;
+
+    // Chorus-like rate with some drift, so both LFO sources are exercised.
+    params.modulation.depthMs = options.modulationDepthMs;
+    params.modulation.rateHz = 0.8f;
+    params.modulation.drift = 0.3f;
+    params.modulation.spread = 0.5f;
+
+    params.diffusion.amount = options.diffusion;
+    params.diffusion.size = 0.6f;
+
+    // Extra taps trail the first one, panned apart, with part of each fed back.
+    params.numTaps = options.numTaps;
+
+    for (int tap = 1; tap < options.numTaps; ++tap)
+    {
+        params.taps[tap].timeMs = params.timeMs + 110.0f * static_cast<float>(tap);
+        params.taps[tap].syncDivision = tap % 2 == 1 ? 7 : 2;
+        params.taps[tap].gain = 0.7f;
+        params.taps[tap].pan = tap % 2 == 1 ? -0.6f : 0.6f;
+        params.taps[tap].feedbackSend = 0.3f;
+    }
+
+    return params;
+}
+
+/** Moves every smoothed parameter each block so the smoothers never settle. */
+void automate(echo::EchoParameters& params, int blockIndex)
+{
+    const float phase = static_cast<float>(blockIndex) * 0.37f;
+    params.timeMs = 300.0f + 200.0f * std::sin(phase);
+    params.feedback = 0.5f + 0.3f * std::sin(phase * 1.3f);
+    params.mix = 0.5f + 0.4f * std::sin(phase * 0.7f);
+    params.lowCutHz = 200.0f + 150.0f * std::sin(phase * 1.1f);
+    params.highCutHz = 6000.0f + 4000.0f * std::sin(phase * 0.9f);
+    params.outputDb = -3.0f + 3.0f * std::sin(phase * 1.7f);
+}
+
+template <typename Sample>
+BenchResult runCase(const BenchCase& benchCase, const Options& options, echo::RealtimeMonitor& monitor)
+{
+    const int numChannels = options.numChannels;
+    const int numInputChannels = benchCase.monoInput ? 1 : numChannels;
+    const int blockSize = benchCase.blockSize;
+
+    // Noise long enough that blocks don't repeat on a short period; copied
+    // into the work buffer outside the timed region.
+    const int sourceLength = std::max(blockSize * 64, 65536);
+    std::vector<Sample> source(static_cast<size_t>(sourceLength) * numChannels);
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    for (auto& sample : source)
+        sample = noise(random);
+
+    std::vector<Sample> work(static_cast<size_t>(blockSize) * numChannels);
+    Sample* channels[echo::kMaxChannels];
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[channel] = work.data() + static_cast<size_t>(channel) * blockSize;
+
+    const int warmupBlocks = static_cast<int>(std::ceil(kWarmupSeconds * benchCase.sampleRate / blockSize));
+    const int timedBlocks = std::max(1, static_cast<int>(std::ceil(options.seconds * benchCase.sampleRate / blockSize)));
+
+    std::vector<double> runNs;
+
+    for (int run = 0; run < options.repeats; ++run)
+    {
+        echo::BasicEchoEngine<Sample> engine;
+        engine.setKernelIsa(options.isa);
+        engine.prepare(benchCase.sampleRate, blockSize, numChannels);
+
+        echo::EchoParameters params = makeParameters(benchCase, options);
+        engine.reset(params);
+        engine.updateDelayLine();
+
+        int sourcePosition = 0;
+        double elapsedNs = 0.0;
+
+        for (int block = 0; block < warmupBlocks + timedBlocks; ++block)
+        {
+            if (sourcePosition + blockSize > sourceLength)
+                sourcePosition = 0;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                std::memcpy(channels[channel], source.data() + static_cast<size_t>(channel) * sourceLength + sourcePosition,
+                            sizeof(Sample) * static_cast<size_t>(blockSize));
+
+            sourcePosition += blockSize;
+
+            if (benchCase.automated)
+                automate(params, block);
+
+            const auto start = std::chrono::steady_clock::now();
+            {
+                echo::RealtimeMonitor::BlockScope realtimeScope(monitor, blockSize, benchCase.sampleRate);
+                engine.process(channels, numChannels, numInputChannels, blockSize, params);
+            }
+            const auto end = std::chrono::steady_clock::now();
+
+            if (block >= warmupBlocks)
+                elapsedNs += std::chrono::duration<double, std::nano>(end - start).count();
+        }
+
+        runNs.push_back(elapsedNs);
+    }
+
+    std::sort(runNs.begin(), runNs.end());
+    const double medianNs = runNs[runNs.size() / 2];
+    const double numSamples = static_cast<double>(timedBlocks) * blockSize;
+
+    BenchResult result;
+    result.benchCase = benchCase;
+    result.nsPerSample = medianNs / numSamples;
+    result.blocksPerSecond = timedBlocks / (medianNs * 1.0e-9);
+    result.realtimeFactor = (numSamples / benchCase.sampleRate) / (medianNs * 1.0e-9);
+    return result;
+}
+
+const char* getDriveQualityName(echo::DriveQuality quality)
+{
+    switch (quality)
+    {
+        case echo::DriveQuality::exact: return "exact";
+        case echo::DriveQuality::table: return "table";
+        case echo::DriveQuality::rational:
+        default: return "rational";
+    }
+}
+
+const char* getDelayStorageName(echo::DelayStorage storage)
+{
+    return storage == echo::DelayStorage::half ? "half" : "full";
+}
+
+int getFilterSlopeDb(echo::FilterSlope slope)
+{
+    return slope == echo::FilterSlope::db24 ? 24 : 12;
+}
+
+const char* getInputName(const BenchCase& benchCase, const Options& options)
+{
+    return benchCase.monoInput ? "mono" : options.numChannels == 2 ? "stereo" : "all";
+}
+
+const char* getOversamplingName(echo::Oversampling mode)
+{
+    switch (mode)
+    {
+        case echo::Oversampling::x2: return "2x";
+        case echo::Oversampling::x4: return "4x";
+        case echo::Oversampling::off:
+        default: return "off";
+    }
+}
+
+void printCsv(const std::vector<BenchResult>& results, const Options& options, const char* kernelName)
+{
+    std::printf("kernel,precision,drive_quality,oversampling,storage,slope,modulation_ms,diffusion,taps,channels,interpolation,sample_rate,block_size,input,ping_pong,sync,automation,"
+                "ns_per_sample,blocks_per_second,realtime_factor\n");
+
+    for (const auto& result : results)
+    {
+        const auto& c = result.benchCase;
+        std::printf("%s,%s,%s,%s,%s,%d,%g,%g,%d,%d,%s,%.0f,%d,%s,%d,%d,%s,%.4f,%.1f,%.1f\n",
+                    kernelName, c.doublePrecision ? "double" : "float", getDriveQualityName(options.driveQuality), getOversamplingName(options.oversampling),
+                    getDelayStorageName(options.delayStorage), getFilterSlopeDb(options.filterSlope), options.modulationDepthMs,
+                    options.diffusion, options.numTaps, options.numChannels, interpolationNames[static_cast<int>(c.interpolation)],
+                    c.sampleRate, c.blockSize, getInputName(c, options), c.pingPong ? 1 : 0, c.sync ? 1 : 0,
+                    c.automated ? "automated" : "static", result.nsPerSample, result.blocksPerSecond,
+                    result.realtimeFactor);
+    }
+}
+
+void printJson(const std::vector<BenchResult>& results, const Options& options, const char* kernelName)
+{
+    std::printf("{\n  \"benchmark\": \"EchoByHDB_bench\",\n  \"kernel\": \"%s\",\n"
+                "  \"drive_quality\": \"%s\",\n  \"oversampling\": \"%s\",\n  \"storage\": \"%s\",\n  \"slope\": %d,\n  \"modulation_ms\": %g,\n  \"diffusion\": %g,\n  \"taps\": %d,\n"
+                "  \"channels\": %d,\n  \"seconds_per_case\": %g,\n  \"repeats\": %d,\n  \"results\": [\n",
+                kernelName, getDriveQualityName(options.driveQuality), getOversamplingName(options.oversampling),
+                getDelayStorageName(options.delayStorage), getFilterSlopeDb(options.filterSlope), options.modulationDepthMs,
+                options.diffusion, options.numTaps, options.numChannels, options.seconds, options.repeats);
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& result = results[i];
+        const auto& c = result.benchCase;
+        std::printf("    { \"precision\": \"%s\", \"interpolation\": \"%s\", \"sample_rate\": %.0f, \"block_size\": %d, \"input\": \"%s\", \"ping_pong\": %s, "
+                    "\"sync\": %s, \"automation\": \"%s\", \"ns_per_sample\": %.4f, "
+                    "\"blocks_per_second\": %.1f, \"realtime_factor\": %.1f }%s\n",
+                    c.doublePrecision ? "double" : "float", interpolationNames[static_cast<int>(c.interpolation)],
+                    c.sampleRate, c.blockSize, getInputName(c, options), c.pingPong ? "true" : "false",
+                    c.sync ? "true" : "false", c.automated ? "automated" : "static", result.nsPerSample,
+                    result.blocksPerSecond, result.realtimeFactor, i + 1 < results.size() ? "," : "");
+    }
+
+    std::printf("  ]\n}\n");
+}
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    echo::RealtimeMonitor monitor;
+    std::vector<BenchResult> results;
+    for (const auto& benchCase : makeMatrix(options))
+        results.push_back(benchCase.doublePrecision ? runCase<double>(benchCase, options, monitor)
+                                                    : runCase<float>(benchCase, options, monitor));
+
+    const char* kernelName = echo::getKernels<float>(options.isa).name;
+
+    if (options.csv)
+        printCsv(results, options, kernelName);
+    else
+        printJson(results, options, kernelName);
+
+    if (options.realtimeReport)
+        std::fprintf(stderr, "%s\n", monitor.formatReport().c_str());
+
+    return 0;
+}
@@ -0,0 +1,460 @@
+// Real-time load test: many processor instances shared out over a thread
+// pool the way a DAW's graph scheduler does, driven by a simulated audio
+// callback with a fixed deadline. Reports deadline misses, callback time
+// percentiles and how many instances fit on a core.
+
+#include <JuceHeader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+#include "PluginProcessor.h"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    int numInstances = 32;
+    int numThreads = 0;             // 0 uses every core
+    int blockSize = 64;
+    int numChannels = 2;
+    double sampleRate = 48000.0;
+    double seconds = 10.0;
+    double warmupSeconds = 0.5;
+    double automationRate = 0.25;   // chance per instance and callback of one parameter change
+    uint32_t seed = 1;
+    bool doublePrecision = false;
+    bool realtimePriority = false;
+    bool json = false;
+};
+
+void printUsage()
+{
+    std::printf("Usage: EchoByHDB_loadtest [options]\n"
+                "  --instances <n>         Processor instances (default 32)\n"
+                "  --threads <n>           Audio threads, the callback thread included\n"
+                "                          (default: one per core)\n"
+                "  --block <frames>        Callback size (default 64)\n"
+                "  --rate <hz>             Sample rate (default 48000)\n"
+                "  --channels <n>          Channels per instance, 1..16 (default 2)\n"
+                "  --seconds <s>           Measured run time (default 10)\n"
+                "  --warmup <s>            Unmeasured run time before it (default 0.5)\n"
+                "  --automation <p>        Chance per instance and callback of a random\n"
+                "                          parameter change, 0..1 (default 0.25)\n"
+                "  --seed <n>              Automation seed (default 1)\n"
+                "  --double                Process in double precision\n"
+                "  --realtime              Run the audio threads SCHED_FIFO (needs the\n"
+                "                          privilege; falls back with a warning)\n"
+                "  --format text|json      Report format (default text)\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        else if (arg == "--double")
+        {
+            options.doublePrecision = true;
+            continue;
+        }
+        else if (arg == "--realtime")
+        {
+            options.realtimePriority = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+
+        const char* value = argv[++i];
+        const std::string text = value;
+
+        if (arg == "--instances" && std::atoi(value) > 0)
+            options.numInstances = std::atoi(value);
+        else if (arg == "--threads" && std::atoi(value) > 0)
+            options.numThreads = std::atoi(value);
+        else if (arg == "--block" && std::atoi(value) > 0)
+            options.blockSize = std::atoi(value);
+        else if (arg == "--rate" && std::atof(value) >= 8000.0)
+            options.sampleRate = std::atof(value);
+        else if (arg == "--channels" && std::atoi(value) >= 1 && std::atoi(value) <= echo::kMaxChannels)
+            options.numChannels = std::atoi(value);
+        else if (arg == "--seconds" && std::atof(value) > 0.0)
+            options.seconds = std::atof(value);
+        else if (arg == "--warmup" && std::atof(value) >= 0.0)
+            options.warmupSeconds = std::atof(value);
+        else if (arg == "--automation" && std::atof(value) >= 0.0 && std::atof(value) <= 1.0)
+            options.automationRate = std::atof(value);
+        else if (arg == "--seed")
+            options.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--format" && (text == "text" || text == "json"))
+            options.json = text == "json";
+        else
+        {
+            std::fprintf(stderr, "Invalid option: %s %s\n", arg.c_str(), value);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void setRealtimePriority()
+{
+#if JUCE_LINUX
+    sched_param param {};
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+        std::fprintf(stderr, "Couldn't switch to SCHED_FIFO; running at normal priority\n");
+#else
+    std::fprintf(stderr, "--realtime is only supported on Linux\n");
+#endif
+}
+
+/** One plugin in the session, with its buffers and automation source. */
+template <typename Sample>
+struct Instance
+{
+    std::unique_ptr<EchoByHdbAudioProcessor> processor;
+    juce::AudioBuffer<Sample> buffer;
+    juce::MidiBuffer midi;
+    juce::Array<juce::AudioProcessorParameter*> automatable;
+    std::minstd_rand random;
+};
+
+/** The session: instances, the callback thread's schedule and the helper
+    threads that share the instances out with it.
+*/
+template <typename Sample>
+class LoadTest
+{
+public:
+    explicit LoadTest(const Options& opts) : options(opts)
+    {
+        const auto layout = juce::AudioChannelSet::canonicalChannelSet(options.numChannels);
+
+        // Built and prepared on the message thread, like a host loading a session.
+        for (int i = 0; i < options.numInstances; ++i)
+        {
+            auto instance = std::make_unique<Instance<Sample>>();
+            instance->processor = std::make_unique<EchoByHdbAudioProcessor>();
+            auto& processor = *instance->processor;
+
+            processor.setBusesLayout({ { layout }, { layout } });
+            processor.setProcessingPrecision(std::is_same_v<Sample, double> ? juce::AudioProcessor::doublePrecision
+                                                                             : juce::AudioProcessor::singlePrecision);
+            processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+            processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+            for (auto* parameter : processor.getParameters())
+                if (parameter->isAutomatable())
+                    instance->automatable.add(parameter);
+
+            instance->buffer.setSize(options.numChannels, options.blockSize);
+            instance->random.seed(options.seed + static_cast<uint32_t>(i) * 7919u);
+            instances.push_back(std::move(instance));
+        }
+
+        // Every instance gets the same noise burst as input each callback.
+        std::minstd_rand noise(options.seed);
+        std::uniform_real_distribution<float> amplitude(-0.5f, 0.5f);
+        input.setSize(options.numChannels, options.blockSize);
+
+        for (int channel = 0; channel < options.numChannels; ++channel)
+            for (int i = 0; i < options.blockSize; ++i)
+                input.setSample(channel, i, static_cast<Sample>(amplitude(noise)));
+
+        const int hardwareThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        numThreads = std::min(options.numThreads > 0 ? options.numThreads : hardwareThreads, options.numInstances);
+        workTime.assign(static_cast<size_t>(numThreads), 0.0);
+    }
+
+    ~LoadTest()
+    {
+        for (auto& instance : instances)
+            instance->processor->releaseResources();
+    }
+
+    /** Runs the callbacks on this thread, with numThreads - 1 helpers. */
+    void run()
+    {
+        if (options.realtimePriority)
+            setRealtimePriority();
+
+        const auto period = std::chrono::duration<double>(options.blockSize / options.sampleRate);
+        const int numWarmup = static_cast<int>(options.warmupSeconds / period.count());
+        const int numMeasured = std::max(1, static_cast<int>(options.seconds / period.count()));
+        callbackTimes.reserve(static_cast<size_t>(numMeasured));
+        firstMeasured = static_cast<uint64_t>(numWarmup) + 1;
+
+        std::vector<std::thread> helpers;
+
+        for (int thread = 1; thread < numThreads; ++thread)
+            helpers.emplace_back([this, thread] { runHelper(thread); });
+
+        auto scheduled = Clock::now();
+
+        for (int callback = 0; callback < numWarmup + numMeasured; ++callback)
+        {
+            // Like a driver, the next callback is due one period after the
+            // last was due; one that overran starts as soon as it can.
+            std::this_thread::sleep_until(scheduled);
+            const auto start = Clock::now();
+
+            remaining.store(options.numInstances);
+            nextInstance.store(0);
+            const uint64_t current = generation.fetch_add(1) + 1;
+
+            processInstances(0, current);
+
+            for (int spins = 0; remaining.load() > 0; ++spins)
+                if (spins > 64)
+                    std::this_thread::yield();
+
+            if (callback >= numWarmup)
+                callbackTimes.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+
+            scheduled += std::chrono::duration_cast<Clock::duration>(period);
+        }
+
+        quit.store(true);
+
+        for (auto& helper : helpers)
+            helper.join();
+    }
+
+    void report() const
+    {
+        const double period = options.blockSize / options.sampleRate;
+        std::vector<double> sorted(callbackTimes);
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto percentile = [&sorted](double p)
+        {
+            const auto index = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+            return sorted[index];
+        };
+
+        double totalCallback = 0.0;
+        int misses = 0;
+
+        for (double time : callbackTimes)
+        {
+            totalCallback += time;
+            misses += time > period ? 1 : 0;
+        }
+
+        double totalWork = 0.0;
+        for (double time : workTime)
+            totalWork += time;
+
+        const auto numCallbacks = static_cast<double>(callbackTimes.size());
+
+        // One instance's processBlock time, averaged; a core that did nothing
+        // else could run period / instanceCost of them. Efficiency compares
+        // the time spent processing with the time the threads were held up
+        // by the callbacks, so scheduling overhead and contention between
+        // threads show up as a drop.
+        const double instanceCost = totalWork / (numCallbacks * options.numInstances);
+        const double instancesPerCore = period / instanceCost;
+        const double efficiency = totalWork / (totalCallback * numThreads);
+
+        juce::uint64 allocations = 0;
+        juce::uint64 blockingCalls = 0;
+
+        for (const auto& instance : instances)
+        {
+            const auto snapshot = instance->processor->getRealtimeMonitor().getSnapshot();
+            allocations += snapshot.allocations;
+            blockingCalls += snapshot.blockingCalls;
+        }
+
+        if (options.json)
+        {
+            std::printf("{\"instances\":%d,\"threads\":%d,\"block_size\":%d,\"sample_rate\":%.0f,\"channels\":%d,"
+                        "\"precision\":\"%s\",\"deadline_us\":%.1f,\"callbacks\":%.0f,\"misses\":%d,"
+                        "\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f,\"mean_load\":%.4f,"
+                        "\"instance_cost_us\":%.3f,\"instances_per_core\":%.1f,\"efficiency\":%.4f",
+                        options.numInstances, numThreads, options.blockSize, options.sampleRate, options.numChannels,
+                        options.doublePrecision ? "double" : "float", period * 1.0e6, numCallbacks, misses,
+                        percentile(50.0) * 1.0e6, percentile(99.0) * 1.0e6, sorted.back() * 1.0e6,
+                        totalCallback / numCallbacks / period, instanceCost * 1.0e6, instancesPerCore, efficiency);
+
+            if (echo::RealtimeMonitor::kEnabled)
+                std::printf(",\"allocations\":%llu,\"blocking_calls\":%llu",
+                            static_cast<unsigned long long>(allocations), static_cast<unsigned long long>(blockingCalls));
+
+            std::printf("}\n");
+            return;
+        }
+
+        std::printf("%d instances on %d threads, %d frames at %.0f Hz (%.1f us deadline), %d channels, %s\n",
+                    options.numInstances, numThreads, options.blockSize, options.sampleRate, period * 1.0e6,
+                    options.numChannels, options.doublePrecision ? "double" : "float");
+        std::printf("callbacks %.0f, deadline misses %d (%.3f%%)\n", numCallbacks, misses, 100.0 * misses / numCallbacks);
+        std::printf("callback p50 %.1f us, p99 %.1f us, max %.1f us, mean load %.1f%%\n",
+                    percentile(50.0) * 1.0e6, percentile(99.0) * 1.0e6, sorted.back() * 1.0e6,
+                    100.0 * totalCallback / numCallbacks / period);
+        std::printf("instance cost %.2f us per block, %.1f instances per core, thread efficiency %.1f%%\n",
+                    instanceCost * 1.0e6, instancesPerCore, 100.0 * efficiency);
+
+        if (echo::RealtimeMonitor::kEnabled)
+            std::printf("audio-thread allocations %llu, blocking calls %llu\n",
+                        static_cast<unsigned long long>(allocations), static_cast<unsigned long long>(blockingCalls));
+    }
+
+    int getNumMisses() const
+    {
+        const double period = options.blockSize / options.sampleRate;
+        return static_cast<int>(std::count_if(callbackTimes.begin(), callbackTimes.end(),
+                                              [period](double time) { return time > period; }));
+    }
+
+private:
+    void runHelper(int thread)
+    {
+        if (options.realtimePriority)
+            setRealtimePriority();
+
+        uint64_t seen = 0;
+
+        // Spins briefly, then yields, while waiting for the next callback;
+        // close to what hosts do to keep wake-up latency off the deadline.
+        for (int spins = 0; ! quit.load();)
+        {
+            const uint64_t current = generation.load();
+
+            if (current != seen)
+            {
+                seen = current;
+                processInstances(thread, current);
+                spins = 0;
+            }
+            else if (++spins > 64)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    /** Takes instances from the shared counter until there are none left.
+        Warm-up callbacks don't count towards the thread's work time.
+    */
+    void processInstances(int thread, uint64_t current)
+    {
+        double elapsed = 0.0;
+
+        for (int index = nextInstance.fetch_add(1); index < options.numInstances; index = nextInstance.fetch_add(1))
+        {
+            auto& instance = *instances[static_cast<size_t>(index)];
+            automate(instance);
+
+            for (int channel = 0; channel < options.numChannels; ++channel)
+                instance.buffer.copyFrom(channel, 0, input, channel, 0, options.blockSize);
+
+            const auto start = Clock::now();
+            instance.processor->processBlock(instance.buffer, instance.midi);
+            elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+
+            remaining.fetch_sub(1);
+        }
+
+        if (current >= firstMeasured)
+            workTime[static_cast<size_t>(thread)] += elapsed;
+    }
+
+    /** A host-side automation point: the new value, then the listener call
+        the plugin wrappers make, on the audio thread before the block.
+    */
+    void automate(Instance<Sample>& instance)
+    {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        if (instance.automatable.isEmpty() || unit(instance.random) >= options.automationRate)
+            return;
+
+        auto* parameter = instance.automatable[static_cast<int>(instance.random() % static_cast<unsigned>(instance.automatable.size()))];
+        const float value = unit(instance.random);
+        parameter->setValue(value);
+        parameter->sendValueChangedMessageToListeners(value);
+    }
+
+    const Options& options;
+    std::vector<std::unique_ptr<Instance<Sample>>> instances;
+    juce::AudioBuffer<Sample> input;
+    int numThreads = 1;
+
+    std::atomic<uint64_t> generation { 0 };
+    uint64_t firstMeasured = 1;     // the generation of the first measured callback
+    std::atomic<int> nextInstance { 0 };
+    std::atomic<int> remaining { 0 };
+    std::atomic<bool> quit { false };
+
+    // Each thread adds only to its own slot, read once the threads are done.
+    std::vector<double> workTime;
+    std::vector<double> callbackTimes;
+};
+
+template <typename Sample>
+int runLoadTest(const Options& options)
+{
+    LoadTest<Sample> test(options);
+    int misses = 0;
+
+    // The audio runs on its own thread while this one dispatches messages,
+    // so the processors' timers (delay-line resizing) run as in a host.
+    std::thread audio([&]
+    {
+        test.run();
+        misses = test.getNumMisses();
+        juce::MessageManager::getInstance()->stopDispatchLoop();
+    });
+
+    juce::MessageManager::getInstance()->runDispatchLoop();
+    audio.join();
+
+    test.report();
+    return misses == 0 ? 0 : 2;
+}
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    return options.doublePrecision ? runLoadTest<double>(options) : runLoadTest<float>(options);
+}
@@ -0,0 +1,442 @@
+// Offline batch renderer: streams WAV files through the plugin processor on
+// a pool of worker threads, each followed by its tail down to silence.
+
+#include <JuceHeader.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "PluginProcessor.h"
+
+namespace
+{
+struct Options
+{
+    juce::File stateFile;
+    juce::StringPairArray overrides;
+    juce::File outputDirectory;
+    juce::Array<juce::File> inputs;
+    int numThreads = 0;             // 0 uses every core
+    int blockSize = 4096;
+    int bitsPerSample = 0;          // 0 keeps the input's
+    double maxTailSeconds = 60.0;
+    double bpm = 0.0;
+    bool doublePrecision = false;
+};
+
+struct RenderResult
+{
+    bool ok = false;
+    juce::String message;
+    double audioSeconds = 0.0;
+    double renderSeconds = 0.0;
+};
+
+void printUsage()
+{
+    std::printf("Usage: EchoByHDB_render [options] <input.wav>...\n"
+                "  --state <file>          Processor state from getStateInformation, as the\n"
+                "                          binary blob a host saves or as its XML\n"
+                "  --set <id>=<value>      Parameter override in the parameter's own units or\n"
+                "                          choice text (--set filterSlope=\"24 dB/oct\"); repeatable\n"
+                "  --out <dir>             Write <name>.wav there (default: <name>_echo.wav\n"
+                "                          next to each input)\n"
+                "  --threads <n>           Worker threads (default: one per core)\n"
+                "  --block <frames>        Frames per processBlock call (default 4096)\n"
+                "  --bits 16|24|32         Output format, 32 is float (default: the input's)\n"
+                "  --max-tail <s>          Longest tail rendered after the input (default 60)\n"
+                "  --bpm <n>               Tempo for synced delay and modulation (default: none)\n"
+                "  --double                Process in double precision\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+
+        if (arg == "--double")
+        {
+            options.doublePrecision = true;
+            continue;
+        }
+
+        if (! arg.startsWith("--"))
+        {
+            options.inputs.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Missing value for %s\n", argv[i]);
+            return false;
+        }
+
+        const juce::String value(argv[++i]);
+
+        if (arg == "--state")
+            options.stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (arg == "--set" && value.containsChar('='))
+            options.overrides.set(value.upToFirstOccurrenceOf("=", false, false).trim(),
+                                  value.fromFirstOccurrenceOf("=", false, false).trim().unquoted());
+        else if (arg == "--out")
+            options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (arg == "--threads" && value.getIntValue() > 0)
+            options.numThreads = value.getIntValue();
+        else if (arg == "--block" && value.getIntValue() >= 16)
+            options.blockSize = value.getIntValue();
+        else if (arg == "--bits" && (value == "16" || value == "24" || value == "32"))
+            options.bitsPerSample = value.getIntValue();
+        else if (arg == "--max-tail" && value.getDoubleValue() >= 0.0)
+            options.maxTailSeconds = value.getDoubleValue();
+        else if (arg == "--bpm" && value.getDoubleValue() > 0.0)
+            options.bpm = value.getDoubleValue();
+        else
+        {
+            std::fprintf(stderr, "Invalid option: %s %s\n", argv[i - 1], argv[i]);
+            return false;
+        }
+    }
+
+    if (options.inputs.isEmpty())
+    {
+        std::fprintf(stderr, "No input files\n");
+        return false;
+    }
+
+    return true;
+}
+
+/** A stopped transport at a fixed tempo, so synced times resolve offline. */
+class FixedTempoPlayHead final : public juce::AudioPlayHead
+{
+public:
+    explicit FixedTempoPlayHead(double tempo) : bpm(tempo) {}
+
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setBpm(bpm);
+        return info;
+    }
+
+private:
+    double bpm;
+};
+
+/** Loads the saved state, then applies the overrides on top of it. */
+bool configureProcessor(EchoByHdbAudioProcessor& processor, const juce::MemoryBlock& state,
+                        const juce::StringPairArray& overrides, juce::String& error)
+{
+    if (! state.isEmpty())
+        processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+
+    auto& apvts = processor.getAPVTS();
+
+    for (const auto& id : overrides.getAllKeys())
+    {
+        auto* parameter = apvts.getParameter(id);
+
+        if (parameter == nullptr)
+        {
+            error = "Unknown parameter: " + id;
+            return false;
+        }
+
+        // Numbers are in the parameter's units (ms, %, Hz, choice index);
+        // anything else goes through its text conversion.
+        const juce::String text = overrides[id];
+        const float normalised = text.containsOnly("0123456789.-+eE")
+                               ? apvts.getParameterRange(id).convertTo0to1(text.getFloatValue())
+                               : parameter->getValueForText(text);
+        parameter->setValueNotifyingHost(normalised);
+    }
+
+    return true;
+}
+
+juce::MemoryBlock loadState(const juce::File& file, juce::String& error)
+{
+    juce::MemoryBlock state;
+
+    if (file == juce::File())
+        return state;
+
+    if (! file.loadFileAsData(state))
+    {
+        error = "Can't read " + file.getFullPathName();
+        return state;
+    }
+
+    // XML as written out by hand or from a preset: wrap it the way
+    // getStateInformation does.
+    if (state.getSize() > 0 && static_cast<const char*>(state.getData())[0] == '<')
+    {
+        const auto xml = juce::parseXML(state.toString());
+        state.reset();
+
+        if (xml == nullptr)
+            error = "Invalid state XML in " + file.getFullPathName();
+        else
+            juce::AudioProcessor::copyXmlToBinary(*xml, state);
+    }
+
+    return state;
+}
+
+std::unique_ptr<juce::AudioFormatReader> openReader(juce::WavAudioFormat& wav, const juce::File& file)
+{
+    // Mapped files are paged in as they're read, so memory use doesn't grow
+    // with the file; formats the mapped reader can't handle are streamed.
+    if (std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped { wav.createMemoryMappedReader(file) };
+        mapped != nullptr && mapped->mapEntireFile())
+        return mapped;
+
+    return std::unique_ptr<juce::AudioFormatReader>(wav.createReaderFor(file.createInputStream().release(), true));
+}
+
+juce::File getOutputFile(const juce::File& input, const Options& options)
+{
+    if (options.outputDirectory != juce::File())
+        return options.outputDirectory.getChildFile(input.getFileNameWithoutExtension() + ".wav");
+
+    return input.getSiblingFile(input.getFileNameWithoutExtension() + "_echo.wav");
+}
+
+template <typename Sample>
+void processFrames(EchoByHdbAudioProcessor& processor, juce::AudioBuffer<float>& io,
+                  juce::AudioBuffer<Sample>& work, int numFrames)
+{
+    juce::MidiBuffer midi;
+
+    if constexpr (std::is_same_v<Sample, float>)
+    {
+        juce::ignoreUnused(work);
+        juce::AudioBuffer<float> block(io.getArrayOfWritePointers(), io.getNumChannels(), numFrames);
+        processor.processBlock(block, midi);
+    }
+    else
+    {
+        work.makeCopyOf(juce::AudioBuffer<float>(io.getArrayOfWritePointers(), io.getNumChannels(), numFrames), true);
+        processor.processBlock(work, midi);
+
+        for (int channel = 0; channel < io.getNumChannels(); ++channel)
+            for (int i = 0; i < numFrames; ++i)
+                io.setSample(channel, i, static_cast<float>(work.getSample(channel, i)));
+    }
+}
+
+template <typename Sample>
+RenderResult renderFile(EchoByHdbAudioProcessor& processor, const juce::File& input, const Options& options)
+{
+    RenderResult result;
+    const auto start = std::chrono::steady_clock::now();
+
+    juce::WavAudioFormat wav;
+    const auto reader = openReader(wav, input);
+
+    if (reader == nullptr)
+    {
+        result.message = "Can't read " + input.getFullPathName();
+        return result;
+    }
+
+    const int numChannels = static_cast<int>(reader->numChannels);
+    const auto layout = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+    if (numChannels > echo::kMaxChannels || ! processor.setBusesLayout({ { layout }, { layout } }))
+    {
+        result.message = "Unsupported channel count " + juce::String(numChannels) + " in " + input.getFullPathName();
+        return result;
+    }
+
+    // Written next to the target and moved over it at the end, so a failed
+    // render never leaves a truncated file behind.
+    const juce::File outputFile = getOutputFile(input, options);
+    juce::TemporaryFile tempFile(outputFile);
+    const int bits = options.bitsPerSample > 0 ? options.bitsPerSample : std::max(16, static_cast<int>(reader->bitsPerSample));
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+
+    if (auto stream = tempFile.getFile().createOutputStream())
+    {
+        writer.reset(wav.createWriterFor(stream.get(), reader->sampleRate, static_cast<unsigned int>(numChannels),
+                                         bits, {}, 0));
+
+        if (writer != nullptr)
+            stream.release();
+    }
+
+    if (writer == nullptr)
+    {
+        result.message = "Can't write " + outputFile.getFullPathName();
+        return result;
+    }
+
+    processor.setProcessingPrecision(std::is_same_v<Sample, double> ? juce::AudioProcessor::doublePrecision
+                                                                     : juce::AudioProcessor::singlePrecision);
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(reader->sampleRate, options.blockSize);
+    processor.prepareToPlay(reader->sampleRate, options.blockSize);
+
+    // One block of audio at a time, so memory stays flat however long the file.
+    juce::AudioBuffer<float> io(numChannels, options.blockSize);
+    juce::AudioBuffer<Sample> work;
+    const juce::int64 inputFrames = reader->lengthInSamples;
+    const juce::int64 maxTailFrames = static_cast<juce::int64>(options.maxTailSeconds * reader->sampleRate);
+    juce::int64 position = 0;
+    bool written = true;
+
+    while (position < inputFrames && written)
+    {
+        const int numFrames = static_cast<int>(std::min<juce::int64>(options.blockSize, inputFrames - position));
+        reader->read(&io, 0, numFrames, position, true, true);
+        processFrames(processor, io, work, numFrames);
+        written = writer->writeFromAudioSampleBuffer(io, 0, numFrames);
+        position += numFrames;
+    }
+
+    // The tail ends once the engine has gone to sleep: nothing above
+    // -100 dB is left in the delay line, so the rest would be silence.
+    for (juce::int64 tail = 0; tail < maxTailFrames && written && ! processor.isAsleep();)
+    {
+        const int numFrames = static_cast<int>(std::min<juce::int64>(options.blockSize, maxTailFrames - tail));
+        io.clear();
+        processFrames(processor, io, work, numFrames);
+        written = writer->writeFromAudioSampleBuffer(io, 0, numFrames);
+        position += numFrames;
+        tail += numFrames;
+    }
+
+    processor.releaseResources();
+    writer.reset();
+
+    if (! written || ! tempFile.overwriteTargetFileWithTemporary())
+    {
+        result.message = "Can't write " + outputFile.getFullPathName();
+        return result;
+    }
+
+    result.ok = true;
+    result.audioSeconds = static_cast<double>(position) / reader->sampleRate;
+    result.renderSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.message = outputFile.getFullPathName();
+    return result;
+}
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    // The processor's parameters and timer expect a message manager, even
+    // though no messages are dispatched here.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::String error;
+    const juce::MemoryBlock state = loadState(options.stateFile, error);
+
+    if (error.isNotEmpty())
+    {
+        std::fprintf(stderr, "%s\n", error.toRawUTF8());
+        return 1;
+    }
+
+    if (options.outputDirectory != juce::File() && ! options.outputDirectory.createDirectory())
+    {
+        std::fprintf(stderr, "Can't create %s\n", options.outputDirectory.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    const int hardwareThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const int numWorkers = std::min(options.numThreads > 0 ? options.numThreads : hardwareThreads, options.inputs.size());
+
+    // Processors are built here on the message thread, one per worker, and
+    // reused for every file that worker takes.
+    FixedTempoPlayHead playHead(options.bpm);
+    std::vector<std::unique_ptr<EchoByHdbAudioProcessor>> processors;
+
+    for (int worker = 0; worker < numWorkers; ++worker)
+    {
+        auto processor = std::make_unique<EchoByHdbAudioProcessor>();
+
+        if (! configureProcessor(*processor, state, options.overrides, error))
+        {
+            std::fprintf(stderr, "%s\n", error.toRawUTF8());
+            return 1;
+        }
+
+        if (options.bpm > 0.0)
+            processor->setPlayHead(&playHead);
+
+        processors.push_back(std::move(processor));
+    }
+
+    std::vector<RenderResult> results(static_cast<size_t>(options.inputs.size()));
+    std::atomic<int> nextInput { 0 };
+    const auto start = std::chrono::steady_clock::now();
+
+    // Files are handed out one at a time, so long and short files balance
+    // across the workers.
+    std::vector<std::thread> threads;
+
+    for (int worker = 0; worker < numWorkers; ++worker)
+    {
+        threads.emplace_back([&, worker]
+        {
+            for (int index = nextInput++; index < options.inputs.size(); index = nextInput++)
+            {
+                auto& processor = *processors[static_cast<size_t>(worker)];
+                results[static_cast<size_t>(index)] = options.doublePrecision
+                    ? renderFile<double>(processor, options.inputs[index], options)
+                    : renderFile<float>(processor, options.inputs[index], options);
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double totalAudioSeconds = 0.0;
+    int failures = 0;
+
+    for (const auto& result : results)
+    {
+        if (result.ok)
+        {
+            totalAudioSeconds += result.audioSeconds;
+            std::printf("%s  %.1f s in %.2f s (%.0fx)\n", result.message.toRawUTF8(), result.audioSeconds,
+                        result.renderSeconds, result.audioSeconds / std::max(result.renderSeconds, 1.0e-9));
+        }
+        else
+        {
+            ++failures;
+            std::fprintf(stderr, "%s\n", result.message.toRawUTF8());
+        }
+    }
+
+    std::printf("%d files, %.1f s of audio in %.2f s on %d threads (%.0fx real time)\n",
+                static_cast<int>(results.size()) - failures, totalAudioSeconds, wallSeconds, numWorkers,
+                totalAudioSeconds / std::max(wallSeconds, 1.0e-9));
+
+    return failures == 0 ? 0 : 1;
+}
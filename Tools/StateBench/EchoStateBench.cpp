@@ -0,0 +1,217 @@
+// Session load/save benchmark: times getStateInformation and
+// setStateInformation per instance for the binary state format, for legacy
+// XML blobs, and for the XML and ValueTree round trip it replaced.
+
+#include <JuceHeader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "PluginProcessor.h"
+
+namespace
+{
+struct Options
+{
+    int numInstances = 256;
+    int repeats = 5;
+};
+
+void printUsage()
+{
+    std::printf("Usage: EchoByHDB_statebench [options]\n"
+                "  --instances <n>         Processor instances, as in a session (default 256)\n"
+                "  --repeats <n>           Passes over all instances; the fastest is reported\n"
+                "                          (default 5)\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+
+        const char* value = argv[++i];
+
+        if (arg == "--instances" && std::atoi(value) > 0)
+            options.numInstances = std::atoi(value);
+        else if (arg == "--repeats" && std::atoi(value) > 0)
+            options.repeats = std::atoi(value);
+        else
+        {
+            std::fprintf(stderr, "Invalid option: %s %s\n", arg.c_str(), value);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/** The state handling before the binary format, kept for comparison. */
+void saveXmlState(EchoByHdbAudioProcessor& processor, juce::MemoryBlock& destination)
+{
+    auto& apvts = processor.getAPVTS();
+
+    if (auto state = apvts.copyState(); state.isValid())
+    {
+        std::unique_ptr<juce::XmlElement> xml(state.createXml());
+        juce::AudioProcessor::copyXmlToBinary(*xml, destination);
+    }
+}
+
+void loadXmlState(EchoByHdbAudioProcessor& processor, const juce::MemoryBlock& source)
+{
+    auto& apvts = processor.getAPVTS();
+    std::unique_ptr<juce::XmlElement> xml(juce::AudioProcessor::getXmlFromBinary(source.getData(), static_cast<int>(source.getSize())));
+
+    if (xml != nullptr && xml->hasTagName(apvts.state.getType()))
+        apvts.replaceState(juce::ValueTree::fromXml(*xml));
+}
+
+/** Fastest pass over all instances, in microseconds per instance. */
+double timePerInstance(int numInstances, int repeats, const std::function<void(int, int)>& operation)
+{
+    double best = 0.0;
+
+    for (int repeat = 0; repeat < repeats; ++repeat)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int index = 0; index < numInstances; ++index)
+            operation(index, repeat);
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = repeat == 0 ? seconds : std::min(best, seconds);
+    }
+
+    return best * 1.0e6 / numInstances;
+}
+
+/** Same values to well within a step of any parameter; the binary format
+    stores plain values, which round-trip through the ranges.
+*/
+bool statesMatch(EchoByHdbAudioProcessor& a, EchoByHdbAudioProcessor& b)
+{
+    const auto& parametersA = a.getParameters();
+    const auto& parametersB = b.getParameters();
+
+    for (int index = 0; index < parametersA.size(); ++index)
+        if (std::abs(parametersA[index]->getValue() - parametersB[index]->getValue()) > 1.0e-5f)
+            return false;
+
+    return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // A session's worth of instances, each with its own settings.
+    std::vector<std::unique_ptr<EchoByHdbAudioProcessor>> sources;
+    std::vector<std::unique_ptr<EchoByHdbAudioProcessor>> targets;
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (int index = 0; index < options.numInstances; ++index)
+    {
+        sources.push_back(std::make_unique<EchoByHdbAudioProcessor>());
+        targets.push_back(std::make_unique<EchoByHdbAudioProcessor>());
+
+        for (auto* parameter : sources.back()->getParameters())
+            parameter->setValueNotifyingHost(unit(random));
+    }
+
+    const auto numInstances = static_cast<size_t>(options.numInstances);
+    std::vector<juce::MemoryBlock> binaryStates(numInstances);
+    std::vector<juce::MemoryBlock> xmlStates(numInstances);
+
+    const double binarySave = timePerInstance(options.numInstances, options.repeats, [&](int index, int)
+    {
+        sources[static_cast<size_t>(index)]->getStateInformation(binaryStates[static_cast<size_t>(index)]);
+    });
+
+    const double xmlSave = timePerInstance(options.numInstances, options.repeats, [&](int index, int)
+    {
+        saveXmlState(*sources[static_cast<size_t>(index)], xmlStates[static_cast<size_t>(index)]);
+    });
+
+    // Each pass loads every instance with another instance's state, so all
+    // values change every time, as they do when a session is opened.
+    const auto pick = [&options](int index, int repeat)
+    {
+        return static_cast<size_t>((index + repeat + 1) % options.numInstances);
+    };
+
+    const double binaryLoad = timePerInstance(options.numInstances, options.repeats, [&](int index, int repeat)
+    {
+        const auto& state = binaryStates[pick(index, repeat)];
+        targets[static_cast<size_t>(index)]->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+    });
+
+    const double legacyLoad = timePerInstance(options.numInstances, options.repeats, [&](int index, int repeat)
+    {
+        const auto& state = xmlStates[pick(index, repeat)];
+        targets[static_cast<size_t>(index)]->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+    });
+
+    const double xmlLoad = timePerInstance(options.numInstances, options.repeats, [&](int index, int repeat)
+    {
+        loadXmlState(*targets[static_cast<size_t>(index)], xmlStates[pick(index, repeat)]);
+    });
+
+    // Both formats must bring back exactly what was saved.
+    bool matched = true;
+
+    for (const auto* states : { &binaryStates, &xmlStates })
+    {
+        for (size_t index = 0; index < numInstances; ++index)
+        {
+            const auto& state = (*states)[index];
+            targets[index]->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+            matched = matched && statesMatch(*sources[index], *targets[index]);
+        }
+    }
+
+    std::printf("%d instances, fastest of %d passes\n", options.numInstances, options.repeats);
+    std::printf("binary state: %zu bytes, save %.2f us, load %.2f us per instance\n",
+                binaryStates.front().getSize(), binarySave, binaryLoad);
+    std::printf("XML state:    %zu bytes, save %.2f us, load %.2f us per instance (XML and ValueTree)\n",
+                xmlStates.front().getSize(), xmlSave, xmlLoad);
+    std::printf("legacy XML read by the binary loader: %.2f us per instance\n", legacyLoad);
+
+    if (! matched)
+    {
+        std::fprintf(stderr, "Loaded parameters differ from the saved ones\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,1154 @@
+// Regression harness for the engine's fast paths: renders deterministic
+// test signals through every optimised configuration and null-tests each
+// against the scalar reference, null-tests the references against the
+// plugin's first per-sample processBlock, checks them against stored golden
+// hashes, runs a long high-feedback pass for stability, and grows the delay
+// line mid-render against one that was long enough all along.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Engine/DenormalGuard.h"
+#include "Engine/EchoEngine.h"
+#include "Engine/LinearSmoother.h"
+
+#ifndef ECHO_VERIFY_GOLDEN_FILE
+ #define ECHO_VERIFY_GOLDEN_FILE "Tools/Verify/golden.txt"
+#endif
+
+namespace
+{
+constexpr double kSampleRate = 48000.0;
+constexpr double kSeconds = 1.5;
+constexpr int kMaxBlockSize = 1024;
+
+/** Block sizes cycled through in every render, so chunk and control-block
+    boundaries land in different places each time round.
+*/
+constexpr int kBlockSchedule[] = { 64, 480, 1, 256, 1024, 37, 128 };
+
+/** Bounds for the references against BaselineEcho, a few times the
+    differences measured: the engine filters with a different topology and
+    computes its controls per chunk.
+*/
+constexpr double kBaselineMaxError = 3.0e-3;
+constexpr double kBaselineMaxRmsDb = -75.0;
+
+const char* const interpolationNames[echo::kNumInterpolations] = { "linear", "hermite", "lagrange", "allpass" };
+
+/** Portable noise: the standard distributions differ between libraries,
+    which would make the golden hashes library-specific.
+*/
+class Noise
+{
+public:
+    explicit Noise(uint32_t seed) noexcept : state(seed * 2654435761u + 1u) {}
+
+    double next() noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<double>(state) / 4294967295.0 * 2.0 - 1.0;
+    }
+
+private:
+    uint32_t state;
+};
+
+/** One test signal with the parameters it runs under. */
+struct Scenario
+{
+    std::string name;
+    int numChannels = 2;
+    int numInputChannels = 2;
+    double seconds = kSeconds;
+    echo::EchoParameters params;
+
+    /** Input sample for a frame and channel. */
+    std::function<double(int frame, int channel)> signal;
+
+    /** Parameter changes before each block; may be empty. */
+    std::function<void(echo::EchoParameters&, int frame)> automation;
+
+    /** Set when the first version of the plugin could play the scenario,
+        so the references are null-tested against BaselineEcho too.
+    */
+    bool baseline = false;
+};
+
+/** One way of running the engine. References are null-tested against
+    nothing and hashed; every other configuration is compared with its
+    reference to the given bounds.
+*/
+struct Configuration
+{
+    std::string name;
+    bool doublePrecision;
+    echo::KernelIsa isa;
+    echo::DriveQuality driveQuality;
+    echo::DelayStorage storage;
+    int reference;          // index of the configuration compared against, -1 for a reference
+    double maxError;        // largest allowed per-sample difference
+    double maxRmsDb;        // largest allowed RMS difference, relative to the reference's RMS
+};
+
+struct Render
+{
+    std::vector<double> samples;   // channel-interleaved
+    uint64_t hash = 0;
+    bool finite = true;
+};
+
+struct Options
+{
+    std::string goldenFile = ECHO_VERIFY_GOLDEN_FILE;
+    bool updateGolden = false;
+    bool allowMissingGolden = false;
+    bool verbose = false;
+};
+
+void printUsage()
+{
+    std::printf("Usage: EchoByHDB_verify [options]\n"
+                "  --golden <file>         Golden hash file (default: the one in the source tree)\n"
+                "  --update-golden         Rewrite this platform's golden hashes instead of\n"
+                "                          checking them; only after an intended change in sound\n"
+                "  --allow-missing-golden  Skip reference renders this platform has no golden\n"
+                "                          hashes for instead of failing them\n"
+                "  --verbose               Print every comparison, not only failures\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        else if (arg == "--update-golden")
+            options.updateGolden = true;
+        else if (arg == "--allow-missing-golden")
+            options.allowMissingGolden = true;
+        else if (arg == "--verbose")
+            options.verbose = true;
+        else if (arg == "--golden" && i + 1 < argc)
+            options.goldenFile = argv[++i];
+        else
+        {
+            std::fprintf(stderr, "Invalid option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/** Golden hashes only hold for one architecture and compiler: the C
+    library's transcendentals and the compiler's floating-point contraction
+    both reach the output.
+*/
+std::string getPlatformName()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    std::string name = "x86_64";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    std::string name = "arm64";
+#else
+    std::string name = "other";
+#endif
+
+#if defined(__clang__)
+    name += "-clang";
+#elif defined(__GNUC__)
+    name += "-gcc";
+#elif defined(_MSC_VER)
+    name += "-msvc";
+#endif
+
+    return name;
+}
+
+const char* getIsaName(echo::KernelIsa isa)
+{
+    switch (isa)
+    {
+        case echo::KernelIsa::sse2: return "sse2";
+        case echo::KernelIsa::avx2: return "avx2";
+        case echo::KernelIsa::neon: return "neon";
+        case echo::KernelIsa::scalar:
+        default: return "scalar";
+    }
+}
+
+std::vector<Configuration> makeConfigurations()
+{
+    using echo::DelayStorage;
+    using echo::DriveQuality;
+    using echo::KernelIsa;
+
+    // Bounds are a few times the differences measured when each path went
+    // in; a path that changes the sound lands well outside them.
+    std::vector<Configuration> configurations = {
+        { "reference-double", true,  KernelIsa::scalar, DriveQuality::exact, DelayStorage::full, -1, 0.0, 0.0 },
+        { "reference-float",  false, KernelIsa::scalar, DriveQuality::exact, DelayStorage::full, -1, 0.0, 0.0 },
+        { "float",            false, KernelIsa::scalar, DriveQuality::exact, DelayStorage::full, 0, 2.0e-4, -100.0 },
+        { "rational-drive",   false, KernelIsa::scalar, DriveQuality::rational, DelayStorage::full, 1, 1.0e-3, -85.0 },
+        { "table-drive",      false, KernelIsa::scalar, DriveQuality::table, DelayStorage::full, 1, 3.0e-4, -80.0 },
+        { "half-storage",     false, KernelIsa::scalar, DriveQuality::exact, DelayStorage::half, 1, 5.0e-2, -50.0 },
+    };
+
+    for (auto isa : { KernelIsa::sse2, KernelIsa::avx2, KernelIsa::neon })
+    {
+        if (! echo::isKernelIsaSupported(isa))
+            continue;
+
+        const std::string name = getIsaName(isa);
+
+        // Only rounding differs from the scalar kernel (and contraction
+        // into FMA in the AVX2 build), so the bounds are tight.
+        configurations.push_back({ name + "-double", true, isa, DriveQuality::exact, DelayStorage::full, 0, 1.0e-12, -250.0 });
+        configurations.push_back({ name + "-float", false, isa, DriveQuality::exact, DelayStorage::full, 1, 2.0e-4, -100.0 });
+    }
+
+    // What a plugin instance runs by default, against the double reference.
+    configurations.push_back({ "default", false, echo::getBestKernelIsa(), echo::kDefaultDriveQuality,
+                               DelayStorage::full, 0, 1.0e-3, -85.0 });
+    return configurations;
+}
+
+double impulses(int frame, int channel)
+{
+    // A click every 0.4 s, the second channel a little later.
+    const int period = static_cast<int>(0.4 * kSampleRate);
+    return frame % period == channel * 300 ? 1.0 : 0.0;
+}
+
+double sweep(int frame, int channel)
+{
+    // Exponential sine sweep, 20 Hz to 20 kHz over the scenario.
+    const double t = frame / kSampleRate;
+    const double rate = std::log(1000.0) / kSeconds;
+    const double phase = 2.0 * 3.14159265358979323846 * 20.0 * (std::exp(rate * t) - 1.0) / rate;
+    return 0.5 * std::sin(phase + channel * 0.5);
+}
+
+std::vector<Scenario> makeScenarios()
+{
+    std::vector<Scenario> scenarios;
+
+    // Noise is generated up front, per channel, so lookups are cheap and
+    // independent of the order frames are asked for.
+    static std::vector<double> noise[echo::kMaxChannels];
+
+    for (int channel = 0; channel < echo::kMaxChannels; ++channel)
+    {
+        Noise source(static_cast<uint32_t>(channel + 1));
+        noise[channel].resize(static_cast<size_t>(kSeconds * kSampleRate) + 1);
+
+        for (auto& sample : noise[channel])
+            sample = 0.5 * source.next();
+    }
+
+    const auto noiseAt = [](int frame, int channel) { return noise[channel][static_cast<size_t>(frame)]; };
+
+    {
+        Scenario s;
+        s.name = "impulse";
+        s.baseline = true;
+        s.params.timeMs = 230.0f;
+        s.params.feedback = 0.7f;
+        s.signal = impulses;
+        scenarios.push_back(s);
+    }
+
+    {
+        Scenario s;
+        s.name = "sweep";
+        s.baseline = true;
+        s.params.timeMs = 125.0f;
+        s.params.feedback = 0.6f;
+        s.params.driveDb = 12.0f;
+        s.signal = sweep;
+        scenarios.push_back(s);
+    }
+
+    {
+        Scenario s;
+        s.name = "noise";
+        s.baseline = true;
+        s.params.timeMs = 333.3f;
+        s.params.feedback = 0.5f;
+        s.params.mix = 0.6f;
+        s.signal = noiseAt;
+        scenarios.push_back(s);
+    }
+
+    {
+        // Every smoothed parameter ramping at once, the delay time included.
+        Scenario s;
+        s.name = "automation";
+        s.signal = noiseAt;
+        s.automation = [](echo::EchoParameters& params, int frame)
+        {
+            const float t = static_cast<float>(frame / kSampleRate);
+            params.timeMs = 50.0f + 600.0f * t;
+            params.feedback = 0.3f + 0.4f * t;
+            params.mix = 0.8f - 0.4f * t;
+            params.lowCutHz = 40.0f + 400.0f * t;
+            params.highCutHz = 16000.0f - 9000.0f * t;
+            params.driveDb = 3.0f + 10.0f * t;
+            params.outputDb = -6.0f + 4.0f * t;
+        };
+        scenarios.push_back(s);
+    }
+
+    {
+        // The gain ramps alone, which the first version smoothed the same
+        // way. Its delay time drifted by samples on a long ramp, adding up
+        // the step per sample in float, and its cutoffs jumped once per
+        // block, so automation can't be null-tested against it.
+        Scenario s;
+        s.name = "gain-ramps";
+        s.baseline = true;
+        s.params.timeMs = 270.0f;
+        s.signal = noiseAt;
+        s.automation = [](echo::EchoParameters& params, int frame)
+        {
+            const float t = static_cast<float>(frame / kSampleRate);
+            params.feedback = 0.3f + 0.4f * t;
+            params.mix = 0.8f - 0.4f * t;
+            params.driveDb = 3.0f + 10.0f * t;
+            params.outputDb = -6.0f + 4.0f * t;
+        };
+        scenarios.push_back(s);
+    }
+
+    {
+        // Tempo-synced delay with the host tempo jumping about.
+        Scenario s;
+        s.name = "tempo";
+        s.baseline = true;
+        s.params.syncEnabled = true;
+        s.params.syncDivision = 3;
+        s.params.feedback = 0.6f;
+        s.signal = impulses;
+        s.automation = [](echo::EchoParameters& params, int frame)
+        {
+            static const double tempos[] = { 120.0, 90.0, 174.0, 60.0 };
+            params.hostBpm = tempos[(frame / 14400) % 4];
+        };
+        scenarios.push_back(s);
+    }
+
+    {
+        Scenario s;
+        s.name = "pingpong";
+        s.baseline = true;
+        s.numInputChannels = 1;
+        s.params.timeMs = 180.0f;
+        s.params.feedback = 0.8f;
+        s.params.pingPong = true;
+        s.signal = impulses;
+        scenarios.push_back(s);
+    }
+
+    {
+        // Six channels circling, so wide kernels see full and part groups.
+        Scenario s;
+        s.name = "surround";
+        s.numChannels = 6;
+        s.numInputChannels = 6;
+        s.params.timeMs = 150.0f;
+        s.params.feedback = 0.6f;
+        s.params.pingPong = true;
+        s.signal = noiseAt;
+        scenarios.push_back(s);
+    }
+
+    {
+        Scenario s;
+        s.name = "modulation";
+        s.params.timeMs = 90.0f;
+        s.params.feedback = 0.6f;
+        s.params.modulation.depthMs = 8.0f;
+        s.params.modulation.rateHz = 1.5f;
+        s.params.modulation.drift = 0.4f;
+        s.signal = sweep;
+        scenarios.push_back(s);
+    }
+
+    {
+        Scenario s;
+        s.name = "taps";
+        s.params.timeMs = 200.0f;
+        s.params.feedback = 0.5f;
+        s.params.filterSlope = echo::FilterSlope::db24;
+        s.params.numTaps = 3;
+        s.params.taps[1] = { 290.0f, 2, 0.7f, -0.6f, 0.3f };
+        s.params.taps[2] = { 410.0f, 2, 0.5f, 0.6f, 0.3f };
+        s.signal = impulses;
+        scenarios.push_back(s);
+    }
+
+    {
+        // Diffusion fading in and growing, with the 4x saturator after it,
+        // so both latencies are compensated at once.
+        Scenario s;
+        s.name = "diffusion";
+        s.params.timeMs = 160.0f;
+        s.params.feedback = 0.7f;
+        s.params.oversampling = echo::Oversampling::x4;
+        s.signal = impulses;
+        s.automation = [](echo::EchoParameters& params, int frame)
+        {
+            const float t = static_cast<float>(frame / kSampleRate);
+            params.diffusion.amount = t < 0.5f ? 0.0f : std::min(1.0f, t - 0.5f);
+            params.diffusion.size = 0.2f + 0.3f * t;
+        };
+        scenarios.push_back(s);
+    }
+
+    return scenarios;
+}
+
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) noexcept
+{
+    // FNV-1a.
+    const auto* bytes = static_cast<const unsigned char*>(data);
+
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+template <typename Sample>
+Render render(const Scenario& scenario, const Configuration& configuration, echo::Interpolation interpolation)
+{
+    const int numChannels = scenario.numChannels;
+    const int numFrames = static_cast<int>(scenario.seconds * kSampleRate);
+
+    echo::EchoParameters params = scenario.params;
+    params.interpolation = interpolation;
+    params.driveQuality = configuration.driveQuality;
+    params.delayStorage = configuration.storage;
+
+    echo::BasicEchoEngine<Sample> engine;
+    engine.setKernelIsa(configuration.isa);
+    engine.prepare(kSampleRate, kMaxBlockSize, numChannels);
+    engine.reset(params);
+    engine.updateDelayLine();
+
+    std::vector<Sample> block(static_cast<size_t>(kMaxBlockSize) * numChannels);
+    Sample* channels[echo::kMaxChannels];
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[channel] = block.data() + static_cast<size_t>(channel) * kMaxBlockSize;
+
+    Render result;
+    result.samples.resize(static_cast<size_t>(numFrames) * numChannels);
+    result.hash = 0xcbf29ce484222325ULL;
+
+    for (int frame = 0, schedule = 0; frame < numFrames; ++schedule)
+    {
+        const int blockSize = std::min(kBlockSchedule[schedule % std::size(kBlockSchedule)], numFrames - frame);
+
+        if (scenario.automation)
+            scenario.automation(params, frame);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                channels[channel][i] = static_cast<Sample>(scenario.signal(frame + i, channel));
+
+        engine.process(channels, numChannels, scenario.numInputChannels, blockSize, params);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            result.hash = hashBytes(result.hash, channels[channel], sizeof(Sample) * static_cast<size_t>(blockSize));
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const double sample = static_cast<double>(channels[channel][i]);
+                result.finite = result.finite && std::isfinite(sample);
+                result.samples[static_cast<size_t>(frame + i) * numChannels + channel] = sample;
+            }
+        }
+
+        frame += blockSize;
+    }
+
+    return result;
+}
+
+/** The plugin's first processBlock, the per-sample float loop the engine
+    replaced, kept as the algorithm the references must still reproduce.
+    Ported off JUCE: juce::SmoothedValue is echo::LinearSmoother, which steps
+    the same way, and the feedback filters are the biquads
+    juce::dsp::IIR::Coefficients made, run in transposed direct form II like
+    juce::dsp::IIR::Filter. It knows stereo, one tap, 12 dB filters, linear
+    interpolation and exact drive, and nothing of modulation, diffusion or
+    oversampling.
+*/
+class BaselineEcho
+{
+public:
+    void prepare(double newSampleRate, int samplesPerBlock, const echo::EchoParameters& params)
+    {
+        sampleRate = newSampleRate;
+        maxDelaySamples = static_cast<int>(std::ceil(sampleRate * (kMaxDelayMs / 1000.0))) + samplesPerBlock;
+
+        for (auto& channel : delayBuffer)
+            channel.assign(static_cast<size_t>(maxDelaySamples), 0.0f);
+
+        writePosition = 0;
+
+        const auto smoothTime = 0.05;
+        timeSmoothed.reset(sampleRate, smoothTime);
+        feedbackSmoothed.reset(sampleRate, smoothTime);
+        mixSmoothed.reset(sampleRate, smoothTime);
+        outputSmoothed.reset(sampleRate, smoothTime);
+
+        timeSmoothed.setCurrentAndTargetValue(params.timeMs);
+        feedbackSmoothed.setCurrentAndTargetValue(params.feedback);
+        mixSmoothed.setCurrentAndTargetValue(params.mix);
+        outputSmoothed.setCurrentAndTargetValue(decibelsToGain(params.outputDb));
+
+        updateFilters(params);
+
+        for (auto& filter : lowCutFilters)
+            filter.reset();
+        for (auto& filter : highCutFilters)
+            filter.reset();
+    }
+
+    /** Processes up to two channels in place. A mono input feeds both, as
+        the engine does.
+    */
+    void process(float* const* channels, int numInputChannels, int numSamples, const echo::EchoParameters& params)
+    {
+        echo::DenormalGuard denormalGuard;
+
+        timeSmoothed.setTargetValue(params.timeMs);
+        feedbackSmoothed.setTargetValue(std::clamp(params.feedback, 0.0f, kFeedbackMax));
+        mixSmoothed.setTargetValue(std::clamp(params.mix, 0.0f, 1.0f));
+        outputSmoothed.setTargetValue(decibelsToGain(params.outputDb));
+
+        updateFilters(params);
+
+        const bool synced = params.syncEnabled && params.hostBpm > 0.0;
+        const float driveGain = decibelsToGain(params.driveDb);
+
+        for (int sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex)
+        {
+            const float targetDelayMs = synced ? getSyncTimeSeconds(params.syncDivision, params.hostBpm) * 1000.0f
+                                               : timeSmoothed.getNextValue();
+
+            const float delaySamples = std::clamp((targetDelayMs / 1000.0f) * static_cast<float>(sampleRate), 1.0f,
+                                                  static_cast<float>(maxDelaySamples - 1));
+
+            const int delaySamplesInt = static_cast<int>(delaySamples);
+            const float frac = delaySamples - static_cast<float>(delaySamplesInt);
+
+            const int readIndexA = (writePosition - delaySamplesInt + maxDelaySamples) % maxDelaySamples;
+            const int readIndexB = (readIndexA - 1 + maxDelaySamples) % maxDelaySamples;
+
+            float delayedSamples[2];
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                const float sampleA = delayBuffer[channel][static_cast<size_t>(readIndexA)];
+                const float sampleB = delayBuffer[channel][static_cast<size_t>(readIndexB)];
+                delayedSamples[channel] = sampleA + frac * (sampleB - sampleA);
+            }
+
+            const float feedbackAmount = feedbackSmoothed.getNextValue();
+            const float mix = mixSmoothed.getNextValue();
+            const float outputGain = outputSmoothed.getNextValue();
+
+            const float feedbackSamples[2] = { delayedSamples[params.pingPong ? 1 : 0],
+                                               delayedSamples[params.pingPong ? 0 : 1] };
+            float outputs[2];
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                const float inputSample = channels[channel < numInputChannels ? channel : 0][sampleIndex];
+                float filtered = lowCutFilters[channel].processSample(feedbackSamples[channel]);
+                filtered = highCutFilters[channel].processSample(filtered);
+                filtered = std::tanh(filtered * driveGain);
+
+                const float feedbackSample = filtered * feedbackAmount;
+                delayBuffer[channel][static_cast<size_t>(writePosition)] = inputSample + feedbackSample;
+
+                const float dryGain = std::cos(mix * kHalfPi);
+                const float wetGain = std::sin(mix * kHalfPi);
+
+                const float outputSample = (inputSample * dryGain) + (delayedSamples[channel] * wetGain);
+                outputs[channel] = outputSample * outputGain;
+            }
+
+            // Written back once both channels have read their input, so a
+            // mono input isn't overwritten before the second channel sees it.
+            channels[0][sampleIndex] = outputs[0];
+            channels[1][sampleIndex] = outputs[1];
+
+            if (++writePosition >= maxDelaySamples)
+                writePosition = 0;
+        }
+    }
+
+private:
+    /** juce::dsp::IIR::Filter<float> running second-order coefficients. */
+    struct Biquad
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        float s1 = 0.0f, s2 = 0.0f;
+
+        void reset() noexcept { s1 = s2 = 0.0f; }
+
+        float processSample(float input) noexcept
+        {
+            const float output = b0 * input + s1;
+            s1 = b1 * input - a1 * output + s2;
+            s2 = b2 * input - a2 * output;
+            return output;
+        }
+    };
+
+    static constexpr int kMaxDelayMs = 2000;
+    static constexpr float kFeedbackMax = 0.95f;
+    static constexpr float kHalfPi = 1.57079632679489661923f;
+    static constexpr float kInverseRootTwo = 0.70710678118654752440f;
+
+    static float decibelsToGain(float decibels) noexcept
+    {
+        return decibels > -100.0f ? std::pow(10.0f, decibels * 0.05f) : 0.0f;
+    }
+
+    static float getSyncTimeSeconds(int divisionIndex, double bpm) noexcept
+    {
+        static const float multipliers[] = { 1.0f, 0.5f, 0.25f, 0.125f, 0.0625f, 0.1666667f, 0.0833333f, 0.75f, 0.375f };
+        const float multiplier = divisionIndex >= 0 && divisionIndex < static_cast<int>(std::size(multipliers))
+                               ? multipliers[divisionIndex] : 0.25f;
+        const double quarterNoteSeconds = 60.0 / bpm;
+        return static_cast<float>(quarterNoteSeconds * 4.0 * multiplier);
+    }
+
+    void updateFilters(const echo::EchoParameters& params) noexcept
+    {
+        // makeHighPass and makeLowPass at the default Q, in float.
+        const float pi = 2.0f * kHalfPi;
+        const float invQ = 1.0f / kInverseRootTwo;
+
+        const float nHigh = std::tan(pi * params.lowCutHz / static_cast<float>(sampleRate));
+        const float nHighSquared = nHigh * nHigh;
+        const float cHigh = 1.0f / (1.0f + invQ * nHigh + nHighSquared);
+
+        const float nLow = 1.0f / std::tan(pi * params.highCutHz / static_cast<float>(sampleRate));
+        const float nLowSquared = nLow * nLow;
+        const float cLow = 1.0f / (1.0f + invQ * nLow + nLowSquared);
+
+        for (auto& filter : lowCutFilters)
+        {
+            filter.b0 = cHigh;
+            filter.b1 = cHigh * -2.0f;
+            filter.b2 = cHigh;
+            filter.a1 = cHigh * 2.0f * (nHighSquared - 1.0f);
+            filter.a2 = cHigh * (1.0f - invQ * nHigh + nHighSquared);
+        }
+
+        for (auto& filter : highCutFilters)
+        {
+            filter.b0 = cLow;
+            filter.b1 = cLow * 2.0f;
+            filter.b2 = cLow;
+            filter.a1 = cLow * 2.0f * (1.0f - nLowSquared);
+            filter.a2 = cLow * (1.0f - invQ * nLow + nLowSquared);
+        }
+    }
+
+    double sampleRate = 44100.0;
+    std::vector<float> delayBuffer[2];
+    int writePosition = 0;
+    int maxDelaySamples = 1;
+
+    echo::LinearSmoother timeSmoothed;
+    echo::LinearSmoother feedbackSmoothed;
+    echo::LinearSmoother mixSmoothed;
+    echo::LinearSmoother outputSmoothed;
+
+    Biquad lowCutFilters[2];
+    Biquad highCutFilters[2];
+};
+
+/** Renders a baseline scenario through BaselineEcho, block for block as
+    render() feeds the engine.
+*/
+Render renderBaseline(const Scenario& scenario)
+{
+    const int numFrames = static_cast<int>(scenario.seconds * kSampleRate);
+    echo::EchoParameters params = scenario.params;
+
+    BaselineEcho baseline;
+    baseline.prepare(kSampleRate, kMaxBlockSize, params);
+
+    std::vector<float> block(2 * static_cast<size_t>(kMaxBlockSize));
+    float* const channels[2] = { block.data(), block.data() + kMaxBlockSize };
+
+    Render result;
+    result.samples.resize(static_cast<size_t>(numFrames) * 2);
+
+    for (int frame = 0, schedule = 0; frame < numFrames; ++schedule)
+    {
+        const int blockSize = std::min(kBlockSchedule[schedule % std::size(kBlockSchedule)], numFrames - frame);
+
+        if (scenario.automation)
+            scenario.automation(params, frame);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                channels[channel][i] = static_cast<float>(scenario.signal(frame + i, channel));
+
+        baseline.process(channels, scenario.numInputChannels, blockSize, params);
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const double sample = static_cast<double>(channels[channel][i]);
+                result.finite = result.finite && std::isfinite(sample);
+                result.samples[static_cast<size_t>(frame + i) * 2 + channel] = sample;
+            }
+        }
+
+        frame += blockSize;
+    }
+
+    return result;
+}
+
+struct Difference
+{
+    double maxError = 0.0;
+    double rmsDb = -std::numeric_limits<double>::infinity();
+};
+
+Difference compare(const std::vector<double>& reference, const std::vector<double>& candidate)
+{
+    double errorEnergy = 0.0;
+    double referenceEnergy = 0.0;
+    Difference difference;
+
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        const double error = candidate[i] - reference[i];
+        difference.maxError = std::max(difference.maxError, std::abs(error));
+        errorEnergy += error * error;
+        referenceEnergy += reference[i] * reference[i];
+    }
+
+    if (errorEnergy > 0.0)
+        difference.rmsDb = 10.0 * std::log10(errorEnergy / std::max(referenceEnergy, 1.0e-30));
+
+    return difference;
+}
+
+/** Golden hashes, keyed "platform configuration case". */
+using GoldenHashes = std::map<std::string, uint64_t>;
+
+GoldenHashes loadGolden(const std::string& path)
+{
+    GoldenHashes golden;
+    std::ifstream file(path);
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        std::istringstream fields(line);
+        std::string platform, configuration, name, hash;
+
+        if (fields >> platform >> configuration >> name >> hash)
+            golden[platform + " " + configuration + " " + name] = std::strtoull(hash.c_str(), nullptr, 16);
+    }
+
+    return golden;
+}
+
+bool saveGolden(const std::string& path, const GoldenHashes& golden)
+{
+    std::ofstream file(path);
+    file << "# Output hashes of the reference configurations for EchoByHDB_verify:\n"
+            "# platform configuration case fnv1a-64. Regenerate a platform's lines with\n"
+            "# --update-golden only when a change to the sound is intended.\n";
+
+    for (const auto& [key, hash] : golden)
+    {
+        char text[24];
+        std::snprintf(text, sizeof(text), "%016" PRIx64, hash);
+        file << key << ' ' << text << '\n';
+    }
+
+    return static_cast<bool>(file);
+}
+
+/** A minute of near-maximum feedback with drive: the loop must stay
+    finite and bounded, with no denormals left in the output.
+*/
+template <typename Sample>
+bool checkStability(const Configuration& configuration, echo::Interpolation interpolation, std::string& failure)
+{
+    echo::EchoParameters params;
+    params.timeMs = 47.0f;
+    params.feedback = echo::EchoEngine::kFeedbackMax;
+    params.mix = 1.0f;
+    params.lowCutHz = 20.0f;
+    params.highCutHz = 20000.0f;
+    params.driveDb = 18.0f;
+    params.interpolation = interpolation;
+    params.driveQuality = configuration.driveQuality;
+    params.delayStorage = configuration.storage;
+    params.modulation.depthMs = 2.0f;
+    params.diffusion.amount = 1.0f;
+
+    echo::BasicEchoEngine<Sample> engine;
+    engine.setKernelIsa(configuration.isa);
+    engine.prepare(kSampleRate, kMaxBlockSize, 2);
+    engine.reset(params);
+    engine.updateDelayLine();
+
+    std::vector<Sample> block(2 * kMaxBlockSize);
+    Sample* channels[] = { block.data(), block.data() + kMaxBlockSize };
+    Noise noise(7);
+    const int numBlocks = static_cast<int>(60.0 * kSampleRate / kMaxBlockSize);
+    double peak = 0.0;
+
+    for (int index = 0; index < numBlocks; ++index)
+    {
+        // A burst at the start, then the loop is left to ring.
+        for (auto& sample : block)
+            sample = static_cast<Sample>(index < 20 ? 0.9 * noise.next() : 0.0);
+
+        engine.process(channels, 2, 2, kMaxBlockSize, params);
+
+        for (auto sample : block)
+        {
+            const double value = static_cast<double>(sample);
+
+            if (! std::isfinite(value))
+            {
+                failure = "non-finite output";
+                return false;
+            }
+
+            if (value != 0.0 && std::abs(value) < static_cast<double>(std::numeric_limits<Sample>::min()))
+            {
+                failure = "denormal output";
+                return false;
+            }
+
+            peak = std::max(peak, std::abs(value));
+        }
+    }
+
+    // tanh holds the loop near unity; with the input added on top the
+    // output can't legitimately go much beyond 2.
+    if (peak > 4.0)
+    {
+        failure = "output peaked at " + std::to_string(peak);
+        return false;
+    }
+
+    return true;
+}
+
+/** The delay line grown partway through a render, with the oversampler's
+    and the diffusion's latencies both compensated, against an engine whose
+    line was long enough from the start. Grown in the same storage, the
+    output must match bit for bit; converted from the other storage on the
+    way, it must stay within that storage's rounding.
+
+    The old line is copied a slice at a time, and a slice that stops among
+    the frames still held back for feedback goes wrong. Blocks are a fixed
+    size here and the line grows one block later on each try, so the slice
+    ends step through every position a block wide, past the held frames.
+*/
+template <typename Sample>
+bool checkLineGrowth(const Configuration& configuration, std::string& failure)
+{
+    constexpr int blockSize = 512;
+    constexpr int numGrowPoints = 40;       // covers a slice of the copy, up to 20480 frames
+    constexpr double maxConvertedError = 1.0e-2;
+    const int firstGrowBlock = static_cast<int>(0.6 * kSampleRate) / blockSize;
+    const int numRingBlocks = static_cast<int>(0.5 * kSampleRate) / blockSize;
+    const auto otherStorage = configuration.storage == echo::DelayStorage::full ? echo::DelayStorage::half
+                                                                               : echo::DelayStorage::full;
+
+    // The second tap only asks for the long line; it is silent and feeds
+    // nothing back, so where it reads doesn't reach the output.
+    echo::EchoParameters grownParams;
+    grownParams.timeMs = 300.0f;
+    grownParams.feedback = 0.7f;
+    grownParams.driveQuality = configuration.driveQuality;
+    grownParams.delayStorage = configuration.storage;
+    grownParams.oversampling = echo::Oversampling::x4;
+    grownParams.diffusion.amount = 1.0f;
+    grownParams.numTaps = 2;
+    grownParams.taps[1] = { 20000.0f, 2, 0.0f, 0.0f, 0.0f };
+
+    for (int point = 0; point < numGrowPoints; ++point)
+    {
+        echo::EchoParameters params[2] = { grownParams, grownParams };
+        params[0].taps[1].timeMs = params[1].taps[1].timeMs = 1000.0f;
+        params[1].delayStorage = otherStorage;
+
+        // The same-storage and the converting engine, then the reference.
+        echo::BasicEchoEngine<Sample> engines[3];
+        std::vector<Sample> blocks[3];
+        Sample* channels[3][2];
+
+        for (int index = 0; index < 3; ++index)
+        {
+            engines[index].setKernelIsa(configuration.isa);
+            engines[index].prepare(kSampleRate, blockSize, 2);
+            engines[index].reset(index < 2 ? params[index] : grownParams);
+            engines[index].updateDelayLine();
+            blocks[index].resize(2 * blockSize);
+            channels[index][0] = blocks[index].data();
+            channels[index][1] = blocks[index].data() + blockSize;
+        }
+
+        Noise noise(11);
+        const int growBlock = firstGrowBlock + point;
+        double convertedError = 0.0;
+
+        for (int block = 0; block <= growBlock + numRingBlocks; ++block)
+        {
+            // The new settings reach the engines with this block; the new
+            // lines are handed over after it, as the plugin's timer would.
+            if (block == growBlock)
+                params[0] = params[1] = grownParams;
+
+            // Noise for the first half second, then the loop rings.
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const double value = block * blockSize + i < kSampleRate / 2 ? 0.5 * noise.next() : 0.0;
+
+                for (auto& engineChannels : channels)
+                {
+                    engineChannels[0][i] = static_cast<Sample>(value);
+                    engineChannels[1][i] = static_cast<Sample>(-value);
+                }
+            }
+
+            for (int index = 0; index < 3; ++index)
+                engines[index].process(channels[index], 2, 2, blockSize, index < 2 ? params[index] : grownParams);
+
+            if (block == growBlock)
+            {
+                engines[0].updateDelayLine();
+                engines[1].updateDelayLine();
+            }
+
+            for (int i = 0; i < 2 * blockSize; ++i)
+            {
+                const auto reference = static_cast<double>(blocks[2][static_cast<size_t>(i)]);
+
+                if (static_cast<double>(blocks[0][static_cast<size_t>(i)]) != reference)
+                {
+                    failure = "grown after block " + std::to_string(growBlock) + ", output differs by "
+                            + std::to_string(std::abs(static_cast<double>(blocks[0][static_cast<size_t>(i)]) - reference));
+                    return false;
+                }
+
+                convertedError = std::max(convertedError, std::abs(static_cast<double>(blocks[1][static_cast<size_t>(i)]) - reference));
+            }
+        }
+
+        if (convertedError > maxConvertedError)
+        {
+            failure = "grown and converted after block " + std::to_string(growBlock) + ", max error "
+                    + std::to_string(convertedError) + " (limit " + std::to_string(maxConvertedError) + ")";
+            return false;
+        }
+
+        if (engines[0].getDelayLineCapacity() != engines[2].getDelayLineCapacity()
+            || engines[1].getDelayLineCapacity() != engines[2].getDelayLineCapacity())
+        {
+            failure = "the line didn't grow";
+            return false;
+        }
+    }
+
+    return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (! parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const std::string platform = getPlatformName();
+    const auto configurations = makeConfigurations();
+    const auto scenarios = makeScenarios();
+    GoldenHashes golden = loadGolden(options.goldenFile);
+
+    int numChecks = 0;
+    int numFailures = 0;
+    int numUnchecked = 0;
+
+    const auto report = [&](bool passed, const std::string& line)
+    {
+        ++numChecks;
+        numFailures += passed ? 0 : 1;
+
+        if (! passed || options.verbose)
+            std::printf("%s %s\n", passed ? "PASS" : "FAIL", line.c_str());
+    };
+
+    for (const auto& scenario : scenarios)
+    {
+        for (int mode = 0; mode < echo::kNumInterpolations; ++mode)
+        {
+            const auto interpolation = static_cast<echo::Interpolation>(mode);
+            const std::string caseName = scenario.name + "/" + interpolationNames[mode];
+            std::vector<Render> renders;
+
+            for (const auto& configuration : configurations)
+                renders.push_back(configuration.doublePrecision ? render<double>(scenario, configuration, interpolation)
+                                                                : render<float>(scenario, configuration, interpolation));
+
+            if (scenario.baseline && interpolation == echo::Interpolation::linear)
+            {
+                const Render baseline = renderBaseline(scenario);
+
+                for (size_t index = 0; index < configurations.size(); ++index)
+                {
+                    if (configurations[index].reference >= 0 || ! renders[index].finite)
+                        continue;
+
+                    const Difference difference = compare(baseline.samples, renders[index].samples);
+                    const bool passed = baseline.finite && difference.maxError <= kBaselineMaxError
+                                     && difference.rmsDb <= kBaselineMaxRmsDb;
+
+                    char text[128];
+                    std::snprintf(text, sizeof(text), " vs baseline: max error %.3g (limit %.3g), rms %.1f dB (limit %.1f dB)",
+                                  difference.maxError, kBaselineMaxError, difference.rmsDb, kBaselineMaxRmsDb);
+                    report(passed, configurations[index].name + " " + caseName + text);
+                }
+            }
+
+            for (size_t index = 0; index < configurations.size(); ++index)
+            {
+                const auto& configuration = configurations[index];
+                const auto& result = renders[index];
+                const std::string label = configuration.name + " " + caseName;
+
+                if (! result.finite)
+                {
+                    report(false, label + ": non-finite output");
+                    continue;
+                }
+
+                if (configuration.reference < 0)
+                {
+                    // References must reproduce the stored output bit for bit.
+                    const std::string key = platform + " " + configuration.name + " " + caseName;
+
+                    if (options.updateGolden)
+                    {
+                        golden[key] = result.hash;
+                        continue;
+                    }
+
+                    const auto stored = golden.find(key);
+
+                    if (stored == golden.end())
+                    {
+                        // A platform without hashes would otherwise pass
+                        // with its references unchecked.
+                        if (options.allowMissingGolden)
+                            ++numUnchecked;
+                        else
+                            report(false, label + ": no golden hash for " + platform);
+
+                        continue;
+                    }
+
+                    char text[64];
+                    std::snprintf(text, sizeof(text), ": hash %016" PRIx64 ", golden %016" PRIx64, result.hash, stored->second);
+                    report(result.hash == stored->second, label + text);
+                    continue;
+                }
+
+                const auto& reference = renders[static_cast<size_t>(configuration.reference)];
+                const Difference difference = compare(reference.samples, result.samples);
+                const bool passed = difference.maxError <= configuration.maxError && difference.rmsDb <= configuration.maxRmsDb;
+
+                char text[128];
+                std::snprintf(text, sizeof(text), " vs %s: max error %.3g (limit %.3g), rms %.1f dB (limit %.1f dB)",
+                              configurations[static_cast<size_t>(configuration.reference)].name.c_str(), difference.maxError,
+                              configuration.maxError, difference.rmsDb, configuration.maxRmsDb);
+                report(passed, label + text);
+            }
+        }
+    }
+
+    for (const auto& configuration : configurations)
+    {
+        for (int mode = 0; mode < echo::kNumInterpolations; ++mode)
+        {
+            std::string failure;
+            const auto interpolation = static_cast<echo::Interpolation>(mode);
+            const bool stable = configuration.doublePrecision ? checkStability<double>(configuration, interpolation, failure)
+                                                              : checkStability<float>(configuration, interpolation, failure);
+            report(stable, configuration.name + " stability/" + interpolationNames[mode]
+                               + (stable ? "" : ": " + failure));
+        }
+
+        std::string failure;
+        const bool matched = configuration.doublePrecision ? checkLineGrowth<double>(configuration, failure)
+                                                           : checkLineGrowth<float>(configuration, failure);
+        report(matched, configuration.name + " line-growth" + (matched ? "" : ": " + failure));
+    }
+
+    if (options.updateGolden)
+    {
+        if (! saveGolden(options.goldenFile, golden))
+        {
+            std::fprintf(stderr, "Can't write %s\n", options.goldenFile.c_str());
+            return 1;
+        }
+
+        std::printf("Golden hashes for %s written to %s\n", platform.c_str(), options.goldenFile.c_str());
+    }
+    else if (numUnchecked > 0)
+    {
+        std::printf("Missing golden hashes for %s allowed: %d reference renders unchecked\n", platform.c_str(),
+                    numUnchecked);
+    }
+
+    std::printf("%d checks, %d failed\n", numChecks, numFailures);
+    return numFailures == 0 ? 0 : 1;
+}